@@ -0,0 +1,473 @@
+#include "../include/scheduler.h"
+#include "../include/globals.h"
+#include "../include/policy.h"
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_TSC 1
+#else
+#define HAVE_TSC 0
+#endif
+
+// Microbenchmark of the scheduler's queue hot paths, without forking: jobs with made-up pids stream
+// through the shared queue as the dispatch loop would see them, and each operation is timed on its own.
+//
+//   enqueue      policy_enqueue() and enqueue(), as queue_jobs() admits a job
+//   exit         what handleSIGCHLD does for a reaped pid: find_process(), retire_process() and the
+//                snapshot publish, under the queue lock
+//   pick_next    one round's pick: policy_on_tick(), policy_pick_next() and start_jobs()
+//   stop_scan    the end of a round: release_running_jobs() before the pick and stop_released_jobs()
+//                after it, as the dispatch loop runs them
+//
+// Signals and /proc sampling are left out; they cost the same whatever the queue layout. The dispatch
+// code runs as is, with signal_job_group pointed at a stub so no made-up pid is ever signalled. For each policy
+// and job count, the queue is filled (it holds at most MAX_PROCESSES jobs), then every round picks, the
+// jobs picked exit and new ones are enqueued in their place until all the jobs have passed through.
+// Results are one JSON object per line, so a saved run can be read back with -c to compare against.
+
+#define BENCH_SLOTS 4
+#define BENCH_TENANTS 4
+#define BENCH_MIN_JOBS 100000   // Small job counts are repeated until this many jobs passed through
+#define BENCH_MAX_RESULTS 128
+#define DEFAULT_RUNS 3
+#define DEFAULT_THRESHOLD 10.0
+
+enum { OP_ENQUEUE, OP_EXIT, OP_PICK, OP_STOP, OP_KINDS };
+static const char *op_names[OP_KINDS] = { "enqueue", "exit", "pick_next", "stop_scan" };
+
+static const struct {
+    const char *name;
+    SchedPolicy policy;
+} policies[] = {
+    { "rr", POLICY_RR }, { "priority", POLICY_PRIORITY }, { "edf", POLICY_EDF },
+    { "srpt", POLICY_SRPT }, { "sjf", POLICY_SJF },
+};
+#define POLICY_COUNT ((int)(sizeof(policies) / sizeof(policies[0])))
+
+// Structure for the cost of one operation summed over a run
+struct Measure {
+    long long ops;
+    long long ns;
+    long long cycles;
+    long long allocations;
+};
+
+// Structure for a timing in progress
+struct Timer {
+    struct timespec start;
+    long long cycles;
+    long long allocations;
+};
+
+// Structure for one reported result, also as read back from a baseline
+struct BenchResult {
+    char op[16];
+    char policy[16];
+    long jobs;
+    int resident;
+    long long ops;
+    double ns_per_op;
+    double cycles_per_op;
+    double allocs_per_op;
+};
+
+static struct BenchResult results[BENCH_MAX_RESULTS];
+static int result_count;
+
+// Heap allocations made by anything in the process, counted by the wrappers below
+static long long allocations;
+
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t count, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+
+void *malloc(size_t size) {
+    allocations++;
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t count, size_t size) {
+    allocations++;
+    return __libc_calloc(count, size);
+}
+
+void *realloc(void *ptr, size_t size) {
+    allocations++;
+    return __libc_realloc(ptr, size);
+}
+
+// Cost of starting and stopping a timer around nothing, taken off every measurement
+static long long overhead_ns, overhead_cycles;
+
+// Function to read the time stamp counter, or 0 where there is none
+static inline long long read_cycles(void) {
+#if HAVE_TSC
+    return (long long)__rdtsc();
+#else
+    return 0;
+#endif
+}
+
+// Function to start timing one operation
+static inline void timer_start(struct Timer *timer) {
+    timer->allocations = allocations;
+    timer->cycles = read_cycles();
+    clock_gettime(CLOCK_MONOTONIC, &timer->start);
+}
+
+// Function to stop timing and add the operation's cost to a measure
+static inline void timer_stop(const struct Timer *timer, struct Measure *measure) {
+    struct timespec end;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    long long cycles = read_cycles() - timer->cycles - overhead_cycles;
+    long long ns = (end.tv_sec - timer->start.tv_sec) * 1000000000LL + end.tv_nsec - timer->start.tv_nsec -
+                   overhead_ns;
+
+    measure->ops++;
+    measure->ns += ns > 0 ? ns : 0;
+    measure->cycles += cycles > 0 ? cycles : 0;
+    measure->allocations += allocations - timer->allocations;
+}
+
+// Function to measure the cheapest empty timing, which is what the timer itself costs
+static void calibrate_timer(void) {
+    long long best_ns = -1, best_cycles = -1;
+    for (int n = 0; n < 10000; n++) {
+        struct Measure measure = { 0, 0, 0, 0 };
+        struct Timer timer;
+        timer_start(&timer);
+        timer_stop(&timer, &measure);
+        if (best_ns == -1 || measure.ns < best_ns) {
+            best_ns = measure.ns;
+        }
+        if (best_cycles == -1 || measure.cycles < best_cycles) {
+            best_cycles = measure.cycles;
+        }
+    }
+    overhead_ns = best_ns;
+    overhead_cycles = best_cycles;
+}
+
+// Function to clear the queues, tenants and runtime model between runs
+static void reset_queue(void) {
+    memset(scheduler_queue, 0, sizeof(*scheduler_queue));
+    scheduler_queue->rear = -1;
+    scheduler_queue->slots = BENCH_SLOTS;
+    if (sem_init(&scheduler_queue->lock, 0, 1) == -1) {
+        perror("sem_init (scheduler_queue lock)");
+        exit(1);
+    }
+    memset(terminated_queue, 0, sizeof(*terminated_queue));
+    terminated_queue->rear = -1;
+    for (int t = 0; t < BENCH_TENANTS; t++) {
+        char name[MAX_TENANT_NAME];
+        snprintf(name, sizeof(name), "bench%d", t);
+        intern_tenant(name);
+    }
+}
+
+// Function to make up the record of job number id, as queue_jobs() would fill it in
+static void make_process(long id, struct Process *process) {
+    memset(process, 0, sizeof(*process));
+    process->pid = (pid_t)(id + 1);
+    process->state = 1;
+    process->priority = 1 + id % 4;
+    process->tenant = id % BENCH_TENANTS;
+    process->progress_slot = -1;
+    process->node = -1;
+    process->waiting_time = TSLICE;
+    process->command_hash = 1 + id % 16;
+    snprintf(process->program, MAX_PROGRAM_KEY, "job%ld", id % 8);
+    snprintf(process->command, MAX_PROGRAM_NAME, "job%ld %ld", id % 8, id % 16);
+    if (id % 8 == 0) {
+        // Some deadline work for EDF admission and picking; loose enough to always be admitted
+        process->deadline = monotonic_ms() + 600000;
+        process->budget = 1;
+    }
+}
+
+// Function standing in for killpg(): the bench's pids are made up
+static int signal_nothing(pid_t pgrp, int sig) {
+    (void)pgrp;
+    (void)sig;
+    return 0;
+}
+
+// Function to add the parts of one operation timed in pieces to a measure, as one operation
+static void add_measure(struct Measure *measure, const struct Measure *part) {
+    measure->ops++;
+    measure->ns += part->ns;
+    measure->cycles += part->cycles;
+    measure->allocations += part->allocations;
+}
+
+// Function to admit and enqueue job number id
+static void enqueue_job(long id, struct Measure *measure) {
+    struct Process process;
+    struct Timer timer;
+
+    make_process(id, &process);
+    timer_start(&timer);
+    if (policy_enqueue(&process, monotonic_ms())) {
+        enqueue(scheduler_queue, process);
+    }
+    timer_stop(&timer, measure);
+}
+
+// Function to stream jobs through the queue under the configured policy, adding to measures[]
+static void run_stream(long jobs, struct Measure measures[]) {
+    int picked[MAX_PROCESSES];
+    long submitted = 0, exited = 0;
+    struct Timer timer;
+
+    reset_queue();
+    while (submitted < jobs && scheduler_queue->rear < MAX_PROCESSES - 1) {
+        enqueue_job(submitted++, &measures[OP_ENQUEUE]);
+    }
+    while (exited < jobs) {
+        // End the last round: the running set is released before the pick, and the released jobs the
+        // pick left out are stopped after it
+        struct Measure end_round = { 0, 0, 0, 0 };
+        timer_start(&timer);
+        release_running_jobs();
+        timer_stop(&timer, &end_round);
+
+        timer_start(&timer);
+        policy_on_tick(monotonic_ms());
+        int free_slots = BENCH_SLOTS - count_in_mask(scheduler_queue->running_mask);
+        int count = policy_pick_next(free_slots > 0 ? free_slots : 0, picked);
+        start_jobs(picked, count);
+        timer_stop(&timer, &measures[OP_PICK]);
+
+        timer_start(&timer);
+        stop_released_jobs();
+        timer_stop(&timer, &end_round);
+        add_measure(&measures[OP_STOP], &end_round);
+
+        // The picked jobs exit, as the reaper sees them, and new ones take their places
+        pid_t pids[BENCH_SLOTS];
+        for (int n = 0; n < count; n++) {
+            pids[n] = scheduler_queue->pids[picked[n]];
+        }
+        if (count == 0) {
+            pids[count++] = scheduler_queue->pids[0];
+        }
+        for (int n = 0; n < count; n++) {
+            timer_start(&timer);
+            sem_wait(&scheduler_queue->lock);
+            int i = find_process(pids[n]);
+            if (i != -1) {
+                retire_process(i, 1, 0);
+            }
+            publish_snapshot(status_snapshot, scheduler_queue, scheduler_queue->slots, terminated_queue->rear + 1);
+            sem_post(&scheduler_queue->lock);
+            timer_stop(&timer, &measures[OP_EXIT]);
+            exited++;
+        }
+        while (submitted < jobs && scheduler_queue->rear < MAX_PROCESSES - 1) {
+            enqueue_job(submitted++, &measures[OP_ENQUEUE]);
+        }
+    }
+}
+
+// Function to benchmark one policy at one job count: the fastest of runs runs, each repeated until
+// BENCH_MIN_JOBS jobs passed through
+static void bench_policy(int p, long jobs, int runs) {
+    struct Measure best[OP_KINDS];
+    long repeats = (BENCH_MIN_JOBS + jobs - 1) / jobs;
+
+    sched_config.policy = policies[p].policy;
+    for (int run = 0; run < runs; run++) {
+        struct Measure measures[OP_KINDS];
+        memset(measures, 0, sizeof(measures));
+        for (long r = 0; r < repeats; r++) {
+            run_stream(jobs, measures);
+        }
+        for (int op = 0; op < OP_KINDS; op++) {
+            if (run == 0 || measures[op].ns * best[op].ops < best[op].ns * measures[op].ops) {
+                best[op] = measures[op];
+            }
+        }
+    }
+
+    for (int op = 0; op < OP_KINDS && result_count < BENCH_MAX_RESULTS; op++) {
+        struct BenchResult *result = &results[result_count++];
+        snprintf(result->op, sizeof(result->op), "%s", op_names[op]);
+        snprintf(result->policy, sizeof(result->policy), "%s", policies[p].name);
+        result->jobs = jobs;
+        result->resident = jobs < MAX_PROCESSES ? (int)jobs : MAX_PROCESSES;
+        result->ops = best[op].ops;
+        result->ns_per_op = (double)best[op].ns / best[op].ops;
+        result->cycles_per_op = HAVE_TSC ? (double)best[op].cycles / best[op].ops : -1;
+        result->allocs_per_op = (double)best[op].allocations / best[op].ops;
+    }
+}
+
+// Function to print one result as a line of JSON
+static void print_result(const struct BenchResult *result, int last) {
+    printf("    {\"op\": \"%s\", \"policy\": \"%s\", \"jobs\": %ld, \"resident\": %d, \"ops\": %lld, "
+           "\"ns_per_op\": %.1f, ", result->op, result->policy, result->jobs, result->resident, result->ops,
+           result->ns_per_op);
+    if (result->cycles_per_op >= 0) {
+        printf("\"cycles_per_op\": %.1f, ", result->cycles_per_op);
+    } else {
+        printf("\"cycles_per_op\": null, ");
+    }
+    printf("\"allocs_per_op\": %.3f}%s\n", result->allocs_per_op, last ? "" : ",");
+}
+
+// Function to find a numeric field in a result line; returns 0 if it is missing
+static int json_number(const char *line, const char *key, double *value) {
+    char pattern[32];
+    snprintf(pattern, sizeof(pattern), "\"%s\": ", key);
+    const char *at = strstr(line, pattern);
+    return at != NULL && sscanf(at + strlen(pattern), "%lf", value) == 1;
+}
+
+// Function to find a string field in a result line; returns 0 if it is missing
+static int json_string(const char *line, const char *key, char *value, size_t size) {
+    char pattern[32];
+    snprintf(pattern, sizeof(pattern), "\"%s\": \"", key);
+    const char *at = strstr(line, pattern);
+    if (at == NULL) {
+        return 0;
+    }
+    at += strlen(pattern);
+    size_t len = strcspn(at, "\"");
+    if (len >= size) {
+        return 0;
+    }
+    memcpy(value, at, len);
+    value[len] = '\0';
+    return 1;
+}
+
+// Function to compare this run's ns/op with a baseline written by an earlier run, on stderr. Returns
+// how many results got slower by more than threshold percent, or -1 if the baseline cannot be read.
+static int compare_baseline(const char *path, double threshold) {
+    FILE *file = fopen(path, "r");
+    if (file == NULL) {
+        perror(path);
+        return -1;
+    }
+
+    char line[512];
+    int regressions = 0, matched = 0;
+    fprintf(stderr, "%-10s %-9s %8s %12s %12s %8s\n", "op", "policy", "jobs", "base ns/op", "ns/op", "change");
+    while (fgets(line, sizeof(line), file) != NULL) {
+        struct BenchResult base;
+        double jobs;
+        if (!json_string(line, "op", base.op, sizeof(base.op)) ||
+            !json_string(line, "policy", base.policy, sizeof(base.policy)) ||
+            !json_number(line, "jobs", &jobs) || !json_number(line, "ns_per_op", &base.ns_per_op)) {
+            continue;
+        }
+        for (int r = 0; r < result_count; r++) {
+            const struct BenchResult *result = &results[r];
+            if (strcmp(result->op, base.op) != 0 || strcmp(result->policy, base.policy) != 0 ||
+                result->jobs != (long)jobs) {
+                continue;
+            }
+            double change = base.ns_per_op > 0 ? (result->ns_per_op / base.ns_per_op - 1) * 100 : 0;
+            int slower = change > threshold;
+            fprintf(stderr, "%-10s %-9s %8ld %12.1f %12.1f %+7.1f%%%s\n", result->op, result->policy,
+                    result->jobs, base.ns_per_op, result->ns_per_op, change, slower ? "  REGRESSED" : "");
+            regressions += slower;
+            matched++;
+        }
+    }
+    fclose(file);
+    if (matched == 0) {
+        fprintf(stderr, "%s: no results to compare with\n", path);
+        return -1;
+    }
+    fprintf(stderr, "%d of %d result(s) more than %.0f%% slower than %s\n", regressions, matched, threshold, path);
+    return regressions;
+}
+
+// Function to print usage
+static void print_usage(const char *prog) {
+    printf("Usage: %s [-r runs] [-c baseline.json [-t percent]] [jobs...]\n", prog);
+    printf("  Times the queue hot paths for every policy with jobs streamed through the queue\n");
+    printf("  (default 10 1000 100000 1000000) and prints the results as JSON. Each figure is the\n");
+    printf("  fastest of -r runs (default %d). With -c the ns/op are compared with an earlier run's\n", DEFAULT_RUNS);
+    printf("  output on stderr, and the exit status is 1 if any is more than -t percent (default %.0f)\n",
+           DEFAULT_THRESHOLD);
+    printf("  slower. Set BENCH_COMMIT to label the output.\n");
+}
+
+int main(int argc, char *argv[]) {
+    const char *baseline = NULL;
+    double threshold = DEFAULT_THRESHOLD;
+    int runs = DEFAULT_RUNS;
+    long sizes[16] = { 10, 1000, 100000, 1000000 };
+    int size_count = 4;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "r:c:t:h")) != -1) {
+        if (opt == 'r' && atoi(optarg) > 0) {
+            runs = atoi(optarg);
+        } else if (opt == 'c') {
+            baseline = optarg;
+        } else if (opt == 't' && atof(optarg) >= 0) {
+            threshold = atof(optarg);
+        } else {
+            print_usage(argv[0]);
+            return opt == 'h' ? 0 : 2;
+        }
+    }
+    if (optind < argc) {
+        size_count = 0;
+        for (; optind < argc && size_count < 16; optind++) {
+            char *end;
+            long jobs = strtol(argv[optind], &end, 10);
+            if (*end != '\0' || jobs < 1) {
+                print_usage(argv[0]);
+                return 2;
+            }
+            sizes[size_count++] = jobs;
+        }
+    }
+
+    // The queues live in ordinary memory here; nothing else shares them
+    static struct ProcessQueue queue;
+    static struct TerminatedQueue terminated;
+    scheduler_queue = &queue;
+    terminated_queue = &terminated;
+    status_snapshot = create_snapshot(NULL);
+    if (status_snapshot == NULL) {
+        return 1;
+    }
+    NCPU = BENCH_SLOTS;
+    TSLICE = DEFAULT_TSLICE;
+    signal_job_group = signal_nothing;
+    if (sem_init(&print_sem, 0, 1) == -1) {
+        perror("sem_init (print_sem)");
+        return 1;
+    }
+    calibrate_timer();
+
+    for (int s = 0; s < size_count; s++) {
+        for (int p = 0; p < POLICY_COUNT; p++) {
+            bench_policy(p, sizes[s], runs);
+        }
+    }
+
+    const char *commit = getenv("BENCH_COMMIT");
+    printf("{\n  \"benchmark\": \"queue_bench\",\n  \"commit\": \"%s\",\n", commit != NULL ? commit : "");
+    printf("  \"max_processes\": %d,\n  \"slots\": %d,\n  \"tenants\": %d,\n  \"runs\": %d,\n",
+           MAX_PROCESSES, BENCH_SLOTS, BENCH_TENANTS, runs);
+    printf("  \"cycles\": \"%s\",\n  \"results\": [\n", HAVE_TSC ? "tsc" : "none");
+    for (int r = 0; r < result_count; r++) {
+        print_result(&results[r], r == result_count - 1);
+    }
+    printf("  ]\n}\n");
+    fflush(stdout);
+
+    if (baseline != NULL) {
+        int regressions = compare_baseline(baseline, threshold);
+        if (regressions != 0) {
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,65 @@
+#ifndef COMMAND_H
+#define COMMAND_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/types.h>
+
+#define MAX_LINE 1024
+#define MAX_ARGS 64
+#define MAX_ENV 16
+#define MAX_PIPELINE 8
+#define LINE_READER_SIZE 65536
+
+// Spawn flags
+#define SPAWN_STOPPED 0x1   // Child stops itself before exec, resumed with SIGCONT
+#define SPAWN_SETSID  0x2   // Child detaches into its own session
+#define SPAWN_NOWAIT  0x4   // With SPAWN_STOPPED: caller calls wait_for_stop() itself
+#define SPAWN_PGROUP  0x8   // Child leads a new process group, so killpg() reaches everything it forks
+
+// Structure to represent one parsed command
+struct Command {
+    char buf[MAX_LINE];         // Storage for every string below
+    char *argv[MAX_ARGS + 1];   // NULL-terminated argument vector
+    int argc;
+    char *env[MAX_ENV + 1];     // Leading NAME=value assignments
+    int envc;
+    char *in_file;              // < file
+    char *out_file;             // > file or >> file
+    char *err_file;             // 2> file or 2>> file
+    int out_append;
+    int err_append;
+    int err_to_out;             // 2>&1
+    const char *dir;            // Directory to run in (submit --dir), NULL for the current one
+};
+
+// Structure to represent commands joined with '|'
+struct Pipeline {
+    struct Command cmds[MAX_PIPELINE];
+    int count;
+};
+
+// Structure to buffer line input read without blocking
+struct LineReader {
+    int fd;
+    char buf[LINE_READER_SIZE];
+    size_t start;               // Offset of the first unconsumed byte
+    size_t len;                 // Offset one past the last buffered byte
+    int eof;
+};
+
+// Function declarations
+int parse_command(const char *line, struct Command *cmd);
+int parse_pipeline(const char *line, struct Pipeline *pipeline);
+int format_command(const struct Command *cmd, char *out, size_t size);
+pid_t spawn_command(const struct Command *cmd, int flags);
+pid_t spawn_captured(const struct Command *cmd, int flags, int *output);
+int spawn_pipeline(const struct Pipeline *pipeline, pid_t pids[], int flags);
+int wait_for_stop(pid_t pid);
+void line_reader_init(struct LineReader *reader, int fd);
+int line_reader_fill(struct LineReader *reader);
+int line_reader_next(struct LineReader *reader, char *line, size_t size);
+
+#endif // COMMAND_H
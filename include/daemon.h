@@ -0,0 +1,19 @@
+#ifndef DAEMON_H
+#define DAEMON_H
+
+#define DEFAULT_SOCKET_PATH "/tmp/shell-scheduler.sock"
+
+// Scheduler daemon request protocol: newline-terminated request lines on a Unix stream socket.
+// Clients may pipeline any number of requests; each gets its reply lines in order, ending with
+// one line that starts with "ok" or "error".
+//
+//   submit <job spec>   ->  ok <pid>  (task id for --lib file.so:entry)
+//   status [pid]        ->  job <pid> <state> <priority> <tenant> <cpu ms> <ipc> <llc mpki> <command>
+//                           (per job; ipc and mpki are "-" without hardware counters)
+//                           ok <count>
+//   cancel <pid>        ->  ok
+//   slots [N|auto]      ->  ok <slots>  (fix the slot count from the next round, or hand it back to
+//                                        NCPU or elastic sizing; no argument shows the current count)
+//   shutdown            ->  ok   (stop accepting requests; exit once the queue drains)
+
+#endif // DAEMON_H
@@ -2,6 +2,7 @@
 #define GLOBALS_H
 
 #include "scheduler.h"
+#include "snapshot.h"
 
 // Global variables declaration
 extern int NCPU;
@@ -10,10 +11,11 @@ extern int shmid;
 
 extern sem_t scheduler_sem;
 extern sem_t print_sem;
-extern sem_t scheduler_queue_sem;
 
 extern struct ProcessQueue* scheduler_queue;
 extern struct ProcessQueue shell_queue;
 extern struct TerminatedQueue* terminated_queue;
+extern struct SchedulerConfig sched_config;
+extern struct SchedulerSnapshot* status_snapshot;
 
 #endif // GLOBALS_H
@@ -0,0 +1,30 @@
+#ifndef PGROUP_H
+#define PGROUP_H
+
+#include <sys/types.h>
+
+#define MAX_GROUP_MEMBERS 256
+
+// Every scheduled job runs in its own process group whose id is the job's pid, so the whole
+// process tree it forks is stopped, continued and charged as one unit. Members are found by walking
+// the tree down from the job's leader through /proc/<pid>/task/<tid>/children, so sampling a job costs
+// reads proportional to its own size rather than to every process on the host; on kernels without
+// children lists /proc is scanned for the groups instead, at most every GROUP_RESCAN_MS. A member whose
+// parent exits is reparented out of the tree: it is still stopped and continued with the group, but
+// may no longer be sampled.
+
+// Structure for one sample of a job's process group
+struct GroupSample {
+    char state;         // R if any thread is runnable, else D if any is in I/O wait, else S, T or '?' if empty
+    long long cpu_ns;   // CPU time of the live members plus the children they have reaped
+    long long rss_kb;   // Resident set of the live members, if asked for
+    int members;        // Live members found
+};
+
+// Function to sample several jobs' process groups from their leaders; returns how many had members
+int sample_process_groups(const pid_t leaders[], int count, struct GroupSample samples[], int with_rss);
+
+// Function to list the threads of a job's live group members; returns how many were stored
+int list_group_threads(pid_t leader, pid_t tids[], int max);
+
+#endif // PGROUP_H
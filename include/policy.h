@@ -0,0 +1,124 @@
+#ifndef POLICY_H
+#define POLICY_H
+
+#include "globals.h"
+
+// Scheduling policy interface. The dispatch engine (engine.c) owns the queue, the scheduler process,
+// slices, accounting and the front-ends; a policy only decides which waiting jobs run and for how long.
+// Each policy is a small module providing some of these hooks:
+//
+//   init      once in the scheduler process, before the first round
+//   enqueue   admission of a new job, with the queue lock held; returns 0 to reject it
+//   on_tick   start of a round, before its jobs are picked, with the queue lock held
+//   pick_next choose up to slots waiting jobs, with the queue lock held; also refills freed slots
+//   slice_ms  length of a round, given the jobs picked for it
+//   on_block  a running job gave up its slot because it is sleeping or in I/O wait
+//   on_exit   a job left the queue, with the queue lock held (in the reaper)
+//
+// The engine calls the policy_* functions below, which switch on the configured policy, so every call
+// in the dispatch loop is a direct call the compiler can see. A policy that has nothing to do for a
+// hook is left out of that hook's switch. To add a policy, add it to SchedPolicy and config.c, write
+// its module, and list its hooks here.
+
+// Round-robin and priority (policy_rr.c)
+int rr_pick_next(int slots, int picked[]);
+int priority_pick_next(int slots, int picked[]);
+int priority_slice_ms(const int picked[], int count);
+
+// Earliest deadline first (deadline.c)
+int edf_enqueue(struct Process *process, long long now);
+void edf_on_tick(long long now);
+int edf_pick_next(int slots, int picked[]);
+void edf_on_exit(const struct Process *process);
+
+// Shortest remaining and shortest predicted run time first (policy_sjf.c)
+int srpt_pick_next(int slots, int picked[]);
+int sjf_pick_next(int slots, int picked[]);
+void sized_on_block(int i);
+
+// Shared by the policies: deficit round-robin between tenants over precomputed ranks (fairshare.c), and
+// the critical path of --after dependents as a rank (dag.c)
+int fair_share_pick(int slots, int picked[], int count, char taken[], const long long rank[], int by_level);
+void rank_by_critical_path(long long rank[]);
+
+// Function to set up the configured policy
+static inline void policy_init(void) {
+    switch (sched_config.policy) {
+    default:
+        break; // None of the built-in policies keeps state outside the queue
+    }
+}
+
+// Function to admit a new job under the configured policy; returns 0 if it must be rejected
+static inline int policy_enqueue(struct Process *process, long long now) {
+    switch (sched_config.policy) {
+    case POLICY_EDF:
+        return edf_enqueue(process, now);
+    default:
+        // Deadlines are only enforced by EDF; elsewhere they are tracked for the summary
+        process->deadline_state = process->deadline != 0 ? DEADLINE_ADMITTED : DEADLINE_NONE;
+        return 1;
+    }
+}
+
+// Function to start a round under the configured policy
+static inline void policy_on_tick(long long now) {
+    switch (sched_config.policy) {
+    case POLICY_EDF:
+        edf_on_tick(now);
+        break;
+    default:
+        break;
+    }
+}
+
+// Function to choose up to slots waiting jobs under the configured policy
+static inline int policy_pick_next(int slots, int picked[]) {
+    switch (sched_config.policy) {
+    case POLICY_PRIORITY:
+        return priority_pick_next(slots, picked);
+    case POLICY_EDF:
+        return edf_pick_next(slots, picked);
+    case POLICY_SRPT:
+        return srpt_pick_next(slots, picked);
+    case POLICY_SJF:
+        return sjf_pick_next(slots, picked);
+    default:
+        return rr_pick_next(slots, picked);
+    }
+}
+
+// Function to get the length of a round under the configured policy, in ms
+static inline int policy_slice_ms(const int picked[], int count) {
+    switch (sched_config.policy) {
+    case POLICY_PRIORITY:
+        return priority_slice_ms(picked, count);
+    default:
+        return TSLICE;
+    }
+}
+
+// Function to tell the configured policy that the running job at queue position i blocked
+static inline void policy_on_block(int i) {
+    switch (sched_config.policy) {
+    case POLICY_SRPT:
+    case POLICY_SJF:
+        sized_on_block(i);
+        break;
+    default:
+        break;
+    }
+}
+
+// Function to tell the configured policy that a job left the queue
+static inline void policy_on_exit(const struct Process *process) {
+    switch (sched_config.policy) {
+    case POLICY_EDF:
+        edf_on_exit(process);
+        break;
+    default:
+        break;
+    }
+}
+
+#endif // POLICY_H
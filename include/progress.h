@@ -0,0 +1,44 @@
+#ifndef PROGRESS_H
+#define PROGRESS_H
+
+#include <sys/types.h>
+
+#define PROGRESS_FD_ENV "SCHED_PROGRESS_FD"
+#define PROGRESS_MAGIC 0x53434850u  // "SCHP"
+
+// Progress reporting: the scheduler hands every job an inherited shared-memory table (its descriptor
+// is named in SCHED_PROGRESS_FD) with one slot per queued job, keyed by the job's process group.
+// A job that links this library reports how far along it is; the srpt policy runs the jobs with the
+// least remaining work first. Jobs started any other way can call these functions too: they do nothing.
+
+// Structure for one job's slot
+struct ProgressSlot {
+    pid_t pgid;                 // Job owning the slot, 0 if free; written by the scheduler
+    int yielding;               // Set by the job while it has stopped itself to give up its CPU
+    long long done;             // Work units completed, as last reported
+    long long total;            // Work units in all, 0 if unknown
+    long long remaining_ms;     // CPU time the job expects to still need, -1 if unknown
+};
+
+// Structure for the shared table
+struct ProgressTable {
+    unsigned int magic;
+    int slot_count;
+    int yield_supported;        // The scheduler stops and requeues a job that yields
+    struct ProgressSlot slots[];
+};
+
+// Functions for jobs
+int progress_attach(void);
+void progress_report(long long done, long long total);
+void progress_remaining(long long remaining_ms);
+void progress_yield(void);
+
+// Functions for the scheduler
+int create_progress_table(int slot_count, int yield_supported);
+int claim_progress_slot(pid_t pgid);
+void release_progress_slot(int slot);
+long long reported_remaining_ms(int slot);
+int progress_yielded(int slot);
+
+#endif // PROGRESS_H
@@ -0,0 +1,41 @@
+#ifndef PROTOCOL_H
+#define PROTOCOL_H
+
+#include <stdint.h>
+#include <netinet/in.h>
+#include "command.h"
+
+#define PROTOCOL_VERSION 1
+#define DEFAULT_PORT 7070
+
+// Message types exchanged between the coordinator and its node agents
+typedef enum {
+    MSG_HELLO = 1,      // agent -> coordinator: a = protocol version, b = CPU slots, text = host name
+    MSG_LAUNCH,         // coordinator -> agent: job, text = command line; the job is forked stopped
+    MSG_CONTINUE,       // coordinator -> agent: job
+    MSG_STOP,           // coordinator -> agent: job
+    MSG_STARTED,        // agent -> coordinator: job, a = pid on the node
+    MSG_USAGE,          // agent -> coordinator: job, a = CPU ms used so far (after a stop)
+    MSG_EXIT            // agent -> coordinator: job, a = wait status, b = CPU ms used
+} MessageType;
+
+// Wire format: an 8-byte header (body length, type, reserved) then a body of three 32-bit
+// fields (job, a, b) and optional text; all integers in network byte order
+#define MESSAGE_HEADER_SIZE 8
+#define MESSAGE_FIELDS_SIZE 12
+
+// Structure for a decoded message
+struct Message {
+    MessageType type;
+    uint32_t job;
+    uint32_t a;
+    uint32_t b;
+    char text[MAX_LINE];
+};
+
+// Function declarations
+int send_message(int fd, MessageType type, uint32_t job, uint32_t a, uint32_t b, const char *text);
+int next_message(struct LineReader *reader, struct Message *msg);
+int parse_endpoint(const char *text, struct sockaddr_in *addr);
+
+#endif // PROTOCOL_H
@@ -2,11 +2,13 @@
 #define SCHEDULER_H
 
 #include <stdio.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
 #include <sys/types.h>
 #include <sys/wait.h>
+#include <sys/resource.h>
 #include <signal.h>
 #include <sys/time.h>
 #include <time.h>
@@ -14,39 +16,316 @@
 #include <sys/ipc.h>
 #include <sys/shm.h>
 #include <errno.h>
+#include <limits.h>
+#include "command.h"
+#include "pgroup.h"
+#include "progress.h"
 
 #define MAX_PROCESSES 100
 #define MAX_PROGRAM_NAME 256
+#define DEFAULT_TSLICE 100
+#define DEFAULT_BATCH_SIZE 64
+#define INGEST_BACKLOG 4096
+#define MAX_TENANTS 32
+#define MAX_TENANT_NAME 32
+#define MAX_SPEC_ERROR 256
+#define DEFAULT_PSI_LIMIT 10
+#define DEFAULT_LOG_CAP_KB 10240
+#define DEFAULT_LOG_KEEP 3
+#define SAMPLE_INTERVAL_MS 5
+#define ELASTIC_SAMPLE_MS 1000
+#define MAX_DEPENDENCIES 8
+#define MAX_JOB_OUTCOMES 16384
+#define MAX_RUNTIME_STATS 256
+#define MAX_PROGRAM_KEY 64
+#define QUEUE_MASK_WORDS ((MAX_PROCESSES + 63) / 64)
 
-// Structure to represent a process
+// Scheduling policies
+typedef enum {
+    POLICY_DEFAULT,     // Round-robin for the basic scheduler, priority for the advanced one
+    POLICY_RR,
+    POLICY_PRIORITY,
+    POLICY_EDF,
+    POLICY_SRPT,        // Least remaining work first, as reported through progress.h or predicted
+    POLICY_SJF          // Shortest predicted run time first
+} SchedPolicy;
+
+// Deadline handling of a process
+typedef enum {
+    DEADLINE_NONE,
+    DEADLINE_ADMITTED,  // Scheduled earliest-deadline-first ahead of fair-share work
+    DEADLINE_DEFERRED,  // Held back until admission control finds room for it
+    DEADLINE_DEMOTED    // Could no longer be admitted in time; runs as ordinary work
+} DeadlineState;
+
+// What admission control does with a deadline job that does not fit
+typedef enum {
+    ADMISSION_REJECT,
+    ADMISSION_DEFER
+} AdmissionMode;
+
+// Per-job performance counters (counters.c). The hardware ones stay 0 without a PMU.
+enum {
+    COUNTER_CYCLES,
+    COUNTER_INSTRUCTIONS,
+    COUNTER_LLC_MISSES,
+    COUNTER_CONTEXT_SWITCHES,
+    COUNTER_PAGE_FAULTS,
+    COUNTER_KINDS
+};
+
+// Which performance counters the scheduler could open on jobs
+typedef enum {
+    COUNTERS_UNTRIED,
+    COUNTERS_HARDWARE,      // PMU events as well as the software ones
+    COUNTERS_SOFTWARE,      // No PMU (most VMs): context switches and page faults only
+    COUNTERS_UNAVAILABLE    // perf_event_open refused (perf_event_paranoid, seccomp)
+} CounterMode;
+
+// Structure to represent a process. Fields read while picking jobs come first; bulky ones that are
+// only used for accounting and output come last.
 struct Process {
     pid_t pid;
-    char command[MAX_PROGRAM_NAME];
-    int state; // 0: Running, 1: Waiting, -1: Finished
-    struct timeval start_time;
-    struct timeval end_time;
+    int state; // 0: Running, 1: Waiting, 2: Blocked (continued, holds no slot), -1: Finished
     long long total_execution_time;
     long long waiting_time;
     int priority;
+    int tenant;                 // Index into ProcessQueue.tenants
+    int progress_slot;          // Slot in the progress table, -1 for none
+    long long quantum_end;      // Monotonic ms until which a sized quantum keeps it running, 0 for none
+    uint64_t command_hash;      // Key for run time predictions, with program
+    long long last_dispatch;    // Scheduler tick this process last started running
+    long long deadline;         // Absolute monotonic deadline in ms, 0 for none
+    long long budget;           // CPU time the job needs by its deadline, in ms
+    long long finish_time;      // Monotonic time the process terminated, in ms
+    DeadlineState deadline_state;
+    double miss_rate;           // Recent LLC misses per 1000 instructions, 0 until measured
+    long rss_kb;                // Largest resident set seen, used as the working-set estimate
+    long long cpu_ns;           // CPU time used as of the last sample, in ns
+    long long slice_cpu_ns;     // ... and as of the start of its current slice
+    int node;                   // Coordinator mode: agent running the job, -1 until launched
+    pid_t remote_pid;           // ... and its pid on that node
+    int in_process;             // A --lib task run on the front-end's worker pool; pid is its task id
+    long long counters[COUNTER_KINDS]; // Performance counter totals as of the last sample
+    long long seq;              // Submission number, never reused; dependencies refer to jobs by it
+    long long after[MAX_DEPENDENCIES]; // Submission numbers of jobs that must succeed before this one runs
+    int after_count;
+    pid_t failed_parent;        // Dependency whose failure cancelled this job, 0 if none
+    int exit_status;            // Wait status once finished, -1 if lost or cancelled
+    struct timeval start_time;
+    struct timeval end_time;
+    char program[MAX_PROGRAM_KEY]; // Program name, the key for run time predictions
+    char command[MAX_PROGRAM_NAME];
+};
+
+// Structure to represent a tenant (user or group) sharing the CPUs by weight
+struct Tenant {
+    char name[MAX_TENANT_NAME];
+    int weight;
+    int deficit;                // Deficit round-robin credit, in slot-ticks
+    long long usage;            // CPU time given to the tenant's processes, in ms
+    int processes;              // Processes submitted under this tenant
+};
+
+// Structure for the observed run time of a command line, or of a program over all its arguments
+struct RuntimeStat {
+    char program[MAX_PROGRAM_KEY];
+    uint64_t command_hash;      // Hash of the argument vector, 0 for the program-wide entry
+    double mean;                // Exponentially weighted mean of successful runs, in ms of CPU
+    double variance;            // ... and variance, in ms squared
+    int samples;
+    long long last_used;        // Scheduler tick of the last update, for eviction
+};
+
+// Structure for a configured tenant weight
+struct TenantWeight {
+    char name[MAX_TENANT_NAME];
+    int weight;
 };
 
 // Structure to represent a queue of processes
 struct ProcessQueue {
     struct Process processes[MAX_PROCESSES];
     int rear;
+    // Dense per-position copies of what every scan tests, so a scan of the queue reads a few cache
+    // lines instead of every record. Kept in step by enqueue(), set_process_state() and retire_process().
+    pid_t pids[MAX_PROCESSES];
+    uint64_t waiting_mask[QUEUE_MASK_WORDS];    // Positions in state 1
+    uint64_t running_mask[QUEUE_MASK_WORDS];    // ... in state 0
+    uint64_t blocked_mask[QUEUE_MASK_WORDS];    // ... in state 2
+    sem_t lock; // Shared by the shell and scheduler processes
+    struct Tenant tenants[MAX_TENANTS];
+    int tenant_count;
+    int tenant_cursor;          // Tenant whose deficit round-robin turn is next
+    long long tick;             // Number of dispatch rounds so far
+    int dependent_jobs;         // Queued processes still waiting on --after parents
+    int deadline_jobs;          // Deadline processes that have terminated
+    int deadline_misses;        // ... and how many of them finished late
+    int deadline_rejected;      // Deadline jobs refused by admission control
+    long long pressure_rounds;  // Rounds dispatched with fewer slots because of PSI stalls
+    long long memory_holds;     // Waiting processes skipped because their working set did not fit
+    long long blocked_releases; // Slots given up by processes found sleeping or in I/O wait
+    long long wake_boosts;      // Blocked processes given a slot back as soon as they woke
+    long long yields;           // Slots given up by jobs calling progress_yield()
+    long long kept_running;     // Jobs picked again at the end of a slice, left running without signals
+    long long preemptions;      // ... and jobs stopped because the pick left them out
+    CounterMode counter_mode;
+    long long counter_totals[COUNTER_KINDS]; // Summed over the jobs that have terminated
+    long long interference_rounds; // Rounds that held a cache-heavy job back from co-running
+    long long interference_holds; // Waiting processes skipped because the round's cache-heavy cap was reached
+    pid_t last_job_id;          // Coordinator mode: id given to the most recent job
+    long long last_seq;         // Submission number given to the most recent job
+    int slots;                  // CPU slots the current round was sized for
+    int slot_override;          // Count fixed with the slots command, 0 to follow NCPU or elastic sizing
+    struct RuntimeStat runtimes[MAX_RUNTIME_STATS];
+    int runtime_count;
 };
 
-// Structure for terminated processes
+// Structure for how a finished job ended, kept for --after lookups long after its record has left the ring
+struct JobOutcome {
+    long long seq;              // Submission number, 0 for a --lib task
+    pid_t pid;                  // Pid (or task id) it was submitted under
+    int exit_status;
+};
+
+// Structure for terminated processes; a ring holding the most recent MAX_PROCESSES entries
 struct TerminatedQueue {
     struct Process processes[MAX_PROCESSES];
-    int rear;
+    int rear; // Total number of terminated processes minus one
+    int draining;   // Set by front-ends that print records as they arrive (drain_terminated_queue)
+    int reported;   // ... and the number printed so far
+    struct JobOutcome outcomes[MAX_JOB_OUTCOMES]; // Ring of the most recent outcomes, for dependencies
+    long long outcome_count;
 };
 
+// Structure to represent a parsed submit request
+struct JobSpec {
+    struct Command cmd;
+    int priority;
+    long long deadline;         // Relative deadline in ms, 0 for none
+    long long budget;           // CPU budget in ms
+    char tenant[MAX_TENANT_NAME];
+    pid_t after[MAX_DEPENDENCIES]; // --after: jobs that must succeed first
+    int after_count;
+    char lib[MAX_PROGRAM_NAME];  // --lib: "file.so:entry" to run in-process, empty for a program
+    int task_library;            // ... and its loaded library, set by prepare_task(); -1 if it cannot run
+    char dir[MAX_PROGRAM_NAME];  // --dir: absolute directory to run the program in, empty for the scheduler's
+    char text[MAX_PROGRAM_NAME]; // Command line as submitted, for accounting output
+};
+
+// Structure for settings taken from the command line or a configuration file
+struct SchedulerConfig {
+    int headless;               // Read job specs from input instead of running the shell
+    char input[PATH_MAX];       // Job spec source: "-" for stdin, a file or a named pipe
+    int binary;                 // Specs are length-prefixed frames instead of lines
+    int batch_size;             // Maximum jobs handed to the scheduler per wake-up
+    struct TenantWeight weights[MAX_TENANTS];
+    int weight_count;
+    SchedPolicy policy;
+    AdmissionMode admission;
+    int memory_aware;           // Size each round by PSI stalls and job working sets
+    int psi_limit;              // Stall percentage (avg10) above which concurrency is cut
+    int passthrough;            // Only admit up to NCPU processes; the kernel shares the CPUs
+    int elastic;                // Resize the slot count at runtime from usable CPUs and host load
+    int counters;               // Attach performance counters to every job
+    int interference_mpki;      // Keep jobs missing the LLC this often (per 1000 instructions) apart, 0 for off
+    char listen[256];           // Coordinator mode: [host:]port node agents connect to
+    int daemon;                 // Serve clients on a Unix socket instead of running the shell
+    char socket[108];           // ... and the socket's path
+    char snapshot[64];          // shm_open() name to export the status snapshot under, if any
+    char log_dir[PATH_MAX];     // Capture each job's stdout/stderr into DIR/<pid>.log, if set
+    int log_cap_kb;             // ... rotating a job's log when it reaches this size
+    int log_keep;               // ... and keeping this many rotated files
+    char runtime_db[PATH_MAX];  // File the runtime model is loaded from and saved to, if set
+    char record[PATH_MAX];      // Trace file every submission and exit is recorded to, if set
+};
+
+// Loop over the queue positions whose bit is set in a state mask, lowest first. The mask is re-read
+// on every step, so the loop body may change the state of the current position.
+#define for_each_in_mask(i, mask) \
+    for (int i = next_in_mask(mask, 0); i != -1; i = next_in_mask(mask, i + 1))
+
 // Function declarations
-void enqueue(struct ProcessQueue* queue, struct Process process);
+int enqueue(struct ProcessQueue* queue, struct Process process);
+void set_process_state(int i, int state);
+int next_in_mask(const uint64_t mask[], int from);
+int count_in_mask(const uint64_t mask[]);
+int find_process(pid_t pid);
+void lock_scheduler_queue(void);
+void unlock_scheduler_queue(void);
 void handleSIGUSR1(int signo);
 void printTerminatedQueue(struct TerminatedQueue* queue);
 void handleSIGCHLD(int signo);
+int parse_job_spec(const char *line, struct JobSpec *spec, int legacy_priority, char error[MAX_SPEC_ERROR]);
+int queue_jobs(struct JobSpec *specs, int count, pid_t scheduler_pid, pid_t ids[]);
+void drain_terminated_queue(int *cursor);
+void run_scheduler_shell(pid_t scheduler_pid, int legacy_priority);
+void shutdown_scheduler(pid_t scheduler_pid);
+int parse_scheduler_args(int argc, char *argv[]);
+void read_scheduler_settings(void);
+void run_batch_ingest(pid_t scheduler_pid, int legacy_priority);
+int set_tenant_weight(const char *name, const char *value);
+int intern_tenant(const char *name);
+void print_tenant_usage(void);
+long long monotonic_ms(void);
+void print_deadline_summary(void);
+int begin_memory_round(int slots);
+int memory_fits(const struct Process *process);
+void memory_charge(const struct Process *process);
+void print_memory_summary(void);
+void note_jobs_to_sample(void);
+void sample_jobs(int with_rss);
+void sample_job_counters(void);
+void attach_job_samples(void);
+extern int (*signal_job_group)(pid_t pgrp, int sig);
+void start_jobs(const int picked[], int count);
+void run_slice(int slice_ms, int slots);
+void release_running_jobs(void);
+void stop_released_jobs(void);
+void print_dispatch_summary(void);
+int apply_kernel_priority(pid_t pid, int level);
+int reprioritise_job(pid_t pid, int level);
+void run_passthrough_scheduler(void);
+void retire_process(int i, long long cpu_ms, int status);
+void run_coordinator(void);
+void run_daemon(pid_t scheduler_pid, int legacy_priority);
+int resolve_dependencies(struct Process *process, const pid_t after[], int after_count);
+void record_outcome(const struct Process *process);
+void release_dependents(const struct Process *parent);
+void record_runtime(const struct Process *process);
+uint64_t command_hash(const struct Command *cmd);
+double predicted_runtime(const struct Process *process, double *stddev);
+long long remaining_estimate(const struct Process *process);
+long long total_estimate(const struct Process *process);
+long long job_quantum(const struct Process *process);
+int load_runtime_model(const char *path);
+int save_runtime_model(const char *path);
+int open_trace(const char *path);
+void trace_submit(const struct JobSpec *spec, pid_t id);
+void trace_exit(const struct Process *process);
+int start_job_logs(void);
+int job_logs_enabled(void);
+void watch_job_output(pid_t pid, int pipe_fd);
+void stop_job_logs(void);
+int usable_cpus(void);
+void sample_host_load(void);
+int update_slots(void);
+int slot_request(const char *args);
+void open_job_counters(const struct Process *process);
+int read_job_counters(pid_t pid, long long values[COUNTER_KINDS]);
+void apply_job_counters(int i, const long long values[COUNTER_KINDS]);
+void begin_interference_round(void);
+int interference_fits(const struct Process *process);
+void interference_charge(const struct Process *process);
+void print_job_counters(const struct Process *process);
+void print_counter_summary(void);
+int prepare_task(const struct JobSpec *spec);
+pid_t submit_task(const struct JobSpec *spec);
+int tasks_outstanding(void);
+void task_records_drained(void);
+void stop_task_pool(void);
+void print_task_summary(void);
+int run_scheduler(SchedPolicy default_policy);
 int run_basic_scheduler(void);
 int run_advanced_scheduler(void);
 
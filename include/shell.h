@@ -7,31 +7,52 @@
 #include <unistd.h>
 #include <sys/wait.h>
 #include <sys/types.h>
+#include <sys/time.h>
+#include <sys/resource.h>
 #include <signal.h>
 #include <time.h>
 #include <ctype.h>
+#include <limits.h>
+#include "command.h"
 
 #define MAX_SIZE 1024
 #define MAX_HIS 200
 
+#define DEFAULT_STATS_TOP 10
+
 // Structure to store command history
 typedef struct {
     char cmd[MAX_SIZE];
     pid_t pid;
     time_t start_time;
     int background;
+    int queued;                 // Background job handed to a scheduler daemon; pid is its job id
+    // Resource usage from wait4(), filled in once the process has been reaped
+    int finished;
+    int status;                 // Wait status
+    long long start_ns;         // Monotonic time the command was started
+    long long wall_us;          // Monotonic time from start to exit
+    long long user_us;
+    long long sys_us;
+    long max_rss_kb;
+    long minor_faults;
+    long major_faults;
+    long voluntary_switches;
+    long involuntary_switches;
 } HistoryEntry;
 
 // Function declarations
 int create_process_and_run(char *cmd, int background);
+int attach_scheduler(const char *path);
+void detach_scheduler(void);
 int execute_piped_commands(char *cmd);
 void sigint_handler(int signo);
 void setup_signal_handler(void);
 void shell_loop(void);
 int launch(char *cmd);
 void display_history(void);
+void display_history_stats(const char *args);
 void trim_whitespace(char *str);
-int history_piped_commands(char *cmd);
 int run_shell(void); // For integration
 
 #endif // SHELL_H
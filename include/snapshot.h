@@ -0,0 +1,65 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include "scheduler.h"
+
+#define SNAPSHOT_MAGIC 0x53434853u  // "SCHS"
+#define SNAPSHOT_READ_ATTEMPTS 1000
+
+// Status snapshot: a copy of the scheduler's state that any number of processes can read without the
+// queue lock. It is rewritten every time the queue lock is released, and readers check the sequence
+// counter (a seqlock) to make sure they never keep a copy that was torn by a concurrent update.
+
+// Structure for one job in a snapshot
+struct JobSnapshot {
+    pid_t pid;
+    int state;                  // As in struct Process
+    int held;                   // Waiting on --after dependencies
+    int priority;
+    long long cpu_ms;
+    long long waiting_ms;
+    double ipc;                 // Instructions per cycle so far, -1 without hardware counters
+    double mpki;                // LLC misses per 1000 instructions so far, -1 without hardware counters
+    char tenant[MAX_TENANT_NAME];
+    char command[MAX_PROGRAM_NAME];
+};
+
+// Structure for the shared snapshot
+struct SchedulerSnapshot {
+    uint32_t magic;
+    uint32_t size;              // sizeof(struct SchedulerSnapshot), so mismatched readers can refuse it
+    uint64_t seq;               // Odd while an update is in progress
+    long long published_ms;     // Monotonic time of the last update
+    long long tick;             // Dispatch rounds so far
+    int ncpu;
+    int running;                // Jobs holding a slot
+    int waiting;
+    int blocked;                // Continued but found sleeping or in I/O wait; they hold no slot
+    long long terminated;       // Jobs finished so far
+    int job_count;
+    struct JobSnapshot jobs[MAX_PROCESSES];
+};
+
+// Function to create the snapshot before the scheduler forks; a name also exports it with shm_open()
+struct SchedulerSnapshot *create_snapshot(const char *name);
+
+// Function to map an exported snapshot read-only
+const struct SchedulerSnapshot *attach_snapshot(const char *name);
+
+// Function to remove an exported snapshot's name
+void remove_snapshot(const char *name);
+
+// Function to publish the queue into the snapshot; callers must hold the queue lock
+void publish_snapshot(struct SchedulerSnapshot *snapshot, const struct ProcessQueue *queue, int ncpu,
+                      long long terminated);
+
+// Function to take a consistent copy of a snapshot without blocking its writer; returns -1 if none
+int read_snapshot(const struct SchedulerSnapshot *snapshot, struct SchedulerSnapshot *copy);
+
+// Function to name a job's state for status output
+const char *snapshot_state_name(const struct JobSnapshot *job);
+
+// Function to format a job's IPC and LLC miss rate for status output, "-" where unknown
+void format_job_counters(const struct JobSnapshot *job, char *out, size_t size);
+
+#endif // SNAPSHOT_H
@@ -0,0 +1,40 @@
+#ifndef TASK_H
+#define TASK_H
+
+#include <time.h>
+
+// In-process tasks: "submit --lib file.so:entry [args...]" loads entry() from a shared library and runs
+// it on the scheduler front-end's pool of worker threads instead of forking a process, for work too
+// short to pay for fork, exec and SIGSTOP/SIGCONT slicing. Build the library with -shared -fPIC.
+//
+// entry() is called with the task's context and returns its exit code (0-255). A task that runs for
+// long should check task_should_yield() at convenient points and, when it says so, keep its progress
+// in ctx->state and return TASK_YIELD: it is queued behind the waiting tasks and called again later
+// with the same context. Tasks share the front-end's address space; one that crashes takes it down.
+
+#define TASK_YIELD (-1)
+
+// Structure handed to a task on every call
+struct TaskContext {
+    int argc;
+    char **argv;                // Arguments after file.so:entry, NULL-terminated
+    void *state;                // The task's own, kept across yields; NULL on the first call
+    int id;                     // Task id, as reported by submit
+    long long slice_end_ns;     // Monotonic time the current time slice ends
+    const volatile int *waiting; // Tasks queued on the pool and waiting for a worker
+};
+
+// Signature of a task entry point
+typedef int (*TaskEntry)(struct TaskContext *ctx);
+
+// Function for a task to check whether its time slice is used up while other tasks are waiting
+static inline int task_should_yield(const struct TaskContext *ctx) {
+    if (*ctx->waiting == 0) {
+        return 0;
+    }
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (long long)now.tv_sec * 1000000000LL + now.tv_nsec >= ctx->slice_end_ns;
+}
+
+#endif // TASK_H
@@ -0,0 +1,17 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#define TRACE_HEADER "# shell-scheduler trace v1"
+
+// Submission trace: a scheduler started with --record FILE appends one tab-separated line per event,
+// so a run can be replayed by bin/replay and compared with another. Times are ms since recording began.
+//
+//   <ms>  submit  <id>  <--after ids, or ->  <submit options and command, quoted as for submit>
+//   <ms>  exit    <id>  <exit code, 128 + signal, or -1 if cancelled or lost>  <CPU ms>
+//
+// Ids are the job pids (job ids in coordinator mode); a replay maps them to the pids of the new run.
+
+#define TRACE_SUBMIT "submit"
+#define TRACE_EXIT "exit"
+
+#endif // TRACE_H
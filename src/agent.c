@@ -0,0 +1,231 @@
+#include "../include/protocol.h"
+#include "../include/pgroup.h"
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <arpa/inet.h>
+
+#define MAX_AGENT_JOBS 256
+
+// Structure for a job running on this node
+struct AgentJob {
+    uint32_t job;   // Coordinator's job id
+    pid_t pid;
+};
+
+static struct AgentJob jobs[MAX_AGENT_JOBS];
+static int job_count = 0;
+static volatile sig_atomic_t child_exited = 0;
+static volatile sig_atomic_t stop_requested = 0;
+
+// Signal handler for SIGCHLD; children are reaped in the main loop
+static void handle_child(int signo) {
+    (void)signo;
+    child_exited = 1;
+}
+
+// Signal handler for SIGTERM and SIGINT; the main loop kills the node's jobs and exits
+static void handle_stop(int signo) {
+    (void)signo;
+    stop_requested = 1;
+}
+
+// Function to find the slot of a job by coordinator id, or -1
+static int find_job(uint32_t job) {
+    for (int i = 0; i < job_count; i++) {
+        if (jobs[i].job == job) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// Function to read the CPU time a job's process group has used so far in ms
+static uint32_t read_cpu_ms(pid_t pid) {
+    struct GroupSample sample;
+    sample_process_groups(&pid, 1, &sample, 0);
+    return (uint32_t)(sample.cpu_ns / 1000000);
+}
+
+// Function to launch a job stopped and report its pid; a pid of 0 means it could not be started
+static void launch_job(int fd, const struct Message *msg) {
+    static struct Command cmd;
+    pid_t pid = 0;
+
+    if (job_count == MAX_AGENT_JOBS) {
+        fprintf(stderr, "Too many jobs on this node; refusing job %u\n", msg->job);
+    } else if (parse_command(msg->text, &cmd) > 0) {
+        pid = spawn_command(&cmd, SPAWN_STOPPED | SPAWN_NOWAIT | SPAWN_PGROUP);
+        if (pid != -1 && !wait_for_stop(pid)) {
+            fprintf(stderr, "Job %u exited before it could be started\n", msg->job);
+            pid = -1;
+        }
+        if (pid == -1) {
+            pid = 0;
+        } else {
+            jobs[job_count].job = msg->job;
+            jobs[job_count].pid = pid;
+            job_count++;
+        }
+    }
+    send_message(fd, MSG_STARTED, msg->job, (uint32_t)pid, 0, NULL);
+    if (pid == 0) {
+        send_message(fd, MSG_EXIT, msg->job, (uint32_t)(127 << 8), 0, NULL);
+    }
+}
+
+// Function to report every job that has exited, with its wait status and CPU time
+static void reap_jobs(int fd) {
+    int status;
+    pid_t pid;
+    struct rusage usage;
+
+    while ((pid = wait4(-1, &status, WNOHANG, &usage)) > 0) {
+        for (int i = 0; i < job_count; i++) {
+            if (jobs[i].pid != pid) {
+                continue;
+            }
+            uint32_t cpu = (uint32_t)((usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000 +
+                                      (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1000);
+            send_message(fd, MSG_EXIT, jobs[i].job, (uint32_t)status, cpu, NULL);
+            killpg(pid, SIGKILL); // Stragglers left in the job's group go with it
+            jobs[i] = jobs[--job_count];
+            break;
+        }
+    }
+}
+
+// Function to act on one message from the coordinator
+static void handle_message(int fd, const struct Message *msg) {
+    int i;
+
+    switch (msg->type) {
+        case MSG_LAUNCH:
+            launch_job(fd, msg);
+            break;
+        case MSG_CONTINUE:
+            if ((i = find_job(msg->job)) != -1) {
+                killpg(jobs[i].pid, SIGCONT);
+            }
+            break;
+        case MSG_STOP:
+            if ((i = find_job(msg->job)) != -1) {
+                killpg(jobs[i].pid, SIGSTOP);
+                send_message(fd, MSG_USAGE, msg->job, read_cpu_ms(jobs[i].pid), 0, NULL);
+            }
+            break;
+        default:
+            fprintf(stderr, "Ignoring unexpected message type %d\n", (int)msg->type);
+            break;
+    }
+}
+
+// Node agent: registers this node's CPU slots with a coordinator and runs the jobs it is sent
+int main(int argc, char *argv[]) {
+    static struct LineReader reader;
+    struct sockaddr_in addr;
+    int slots = 0;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:h")) != -1) {
+        if (opt == 'n') {
+            slots = atoi(optarg);
+            if (slots <= 0) {
+                fprintf(stderr, "Invalid slot count: %s\n", optarg);
+                return 1;
+            }
+        } else {
+            printf("Usage: %s [-n slots] host:port\n", argv[0]);
+            return opt == 'h' ? 0 : 1;
+        }
+    }
+    if (optind != argc - 1) {
+        printf("Usage: %s [-n slots] host:port\n", argv[0]);
+        return 1;
+    }
+    if (parse_endpoint(argv[optind], &addr) == -1) {
+        fprintf(stderr, "Invalid coordinator address: %s\n", argv[optind]);
+        return 1;
+    }
+    if (slots == 0) {
+        long online = sysconf(_SC_NPROCESSORS_ONLN);
+        slots = online > 0 ? (int)online : 1;
+    }
+
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd == -1) {
+        perror("socket");
+        return 1;
+    }
+    if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) == -1) {
+        perror("connect");
+        return 1;
+    }
+
+    char host[256];
+    if (gethostname(host, sizeof(host)) == -1) {
+        strcpy(host, "unknown");
+    }
+    host[sizeof(host) - 1] = '\0';
+    if (send_message(fd, MSG_HELLO, 0, PROTOCOL_VERSION, (uint32_t)slots, host) == -1) {
+        perror("send");
+        return 1;
+    }
+    printf("Registered %d slot(s) with %s\n", slots, argv[optind]);
+    fflush(stdout);
+
+    // Signals are only delivered inside ppoll, like the headless front-end
+    signal(SIGCHLD, handle_child);
+    signal(SIGTERM, handle_stop);
+    signal(SIGINT, handle_stop);
+    sigset_t block, wait_mask;
+    sigemptyset(&block);
+    sigaddset(&block, SIGCHLD);
+    sigaddset(&block, SIGTERM);
+    sigaddset(&block, SIGINT);
+    sigprocmask(SIG_BLOCK, &block, &wait_mask);
+    sigdelset(&wait_mask, SIGCHLD);
+    sigdelset(&wait_mask, SIGTERM);
+    sigdelset(&wait_mask, SIGINT);
+
+    line_reader_init(&reader, fd);
+    while (1) {
+        struct Message msg;
+        int ready;
+        while ((ready = next_message(&reader, &msg)) == 1) {
+            handle_message(fd, &msg);
+        }
+        if (ready == -1 || stop_requested) {
+            break; // Coordinator went away or the agent is shutting down
+        }
+        if (child_exited) {
+            child_exited = 0;
+            reap_jobs(fd);
+        }
+
+        struct pollfd pfd = { fd, POLLIN, 0 };
+        if (ppoll(&pfd, 1, NULL, &wait_mask) == -1) {
+            if (errno != EINTR) {
+                perror("ppoll");
+                break;
+            }
+            continue;
+        }
+        if (pfd.revents != 0 && line_reader_fill(&reader) == -1 && errno != EINTR) {
+            perror("recv");
+            break;
+        }
+    }
+
+    // Jobs cannot outlive their coordinator
+    for (int i = 0; i < job_count; i++) {
+        killpg(jobs[i].pid, SIGKILL);
+        killpg(jobs[i].pid, SIGCONT);
+    }
+    printf("%s; %d job(s) killed\n", stop_requested ? "Agent stopped" : "Coordinator disconnected", job_count);
+    close(fd);
+    return 0;
+}
@@ -0,0 +1,205 @@
+#include "../include/scheduler.h"
+#include "../include/globals.h"
+#include <arpa/inet.h>
+#include <ctype.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdint.h>
+
+// Job specs parsed from input but not yet handed to the scheduler
+static struct JobSpec backlog[INGEST_BACKLOG];
+static int backlog_head = 0;
+static int backlog_count = 0;
+
+// Bytes of an oversized frame still to be discarded from the input
+static size_t frame_skip = 0;
+
+// Function to take the next length-prefixed frame; same return values as line_reader_next, plus 2 for a
+// frame too long to hold, which is skipped
+static int next_frame(struct LineReader *reader, char *frame, size_t size) {
+    size_t avail = reader->len - reader->start;
+    uint32_t length;
+
+    if (frame_skip > 0) {
+        size_t take = avail < frame_skip ? avail : frame_skip;
+        reader->start += take;
+        frame_skip -= take;
+        avail -= take;
+        if (frame_skip > 0) {
+            if (reader->eof) {
+                fprintf(stderr, "Truncated frame at end of input\n");
+                return -1;
+            }
+            reader->start = 0;
+            reader->len = 0;
+            return 0;
+        }
+    }
+    if (avail < sizeof(length)) {
+        if (reader->eof && avail > 0) {
+            fprintf(stderr, "Truncated frame header at end of input\n");
+        }
+        return reader->eof ? -1 : 0;
+    }
+    memcpy(&length, reader->buf + reader->start, sizeof(length));
+    length = ntohl(length); // Lengths are in network byte order, as on the daemon's socket
+    if (length >= size) {
+        fprintf(stderr, "Frame of %u bytes exceeds the %zu byte limit\n", length, size - 1);
+        reader->start += sizeof(length);
+        frame_skip = length;
+        return 2;
+    }
+    if (avail < sizeof(length) + length) {
+        if (reader->eof) {
+            fprintf(stderr, "Truncated frame at end of input\n");
+            return -1;
+        }
+        return 0;
+    }
+
+    memcpy(frame, reader->buf + reader->start + sizeof(length), length);
+    frame[length] = '\0';
+    reader->start += sizeof(length) + length;
+    if (reader->start == reader->len) {
+        reader->start = 0;
+        reader->len = 0;
+    }
+    return 1;
+}
+
+// Function to parse buffered input into the backlog until either runs out; returns -1 at end of input
+static int parse_input(struct LineReader *reader, int legacy_priority, long *spec_number) {
+    char spec_text[MAX_LINE];
+
+    while (backlog_count < INGEST_BACKLOG) {
+        int ready = sched_config.binary ? next_frame(reader, spec_text, sizeof(spec_text))
+                                        : line_reader_next(reader, spec_text, sizeof(spec_text));
+        if (ready == 2) {
+            fprintf(stderr, "Skipping job spec %ld\n", ++*spec_number);
+            continue;
+        }
+        if (ready != 1) {
+            return ready;
+        }
+        (*spec_number)++;
+
+        // Blank lines and comments are skipped; a leading "submit" is optional
+        char *text = spec_text;
+        while (isspace((unsigned char)*text)) {
+            text++;
+        }
+        if (*text == '\0' || *text == '#') {
+            continue;
+        }
+        if (strncmp(text, "submit", 6) == 0 && (text[6] == '\0' || isspace((unsigned char)text[6]))) {
+            text += 6;
+        }
+
+        struct JobSpec *spec = &backlog[(backlog_head + backlog_count) % INGEST_BACKLOG];
+        char error[MAX_SPEC_ERROR];
+        if (parse_job_spec(text, spec, legacy_priority, error) == -1) {
+            fprintf(stderr, "Skipping job spec %ld: %s (%s)\n", *spec_number, spec_text, error);
+            continue;
+        }
+        backlog_count++;
+    }
+    return 0;
+}
+
+// Function to hand as much of the backlog to the scheduler as the queue has room for
+static void flush_backlog(pid_t scheduler_pid) {
+    while (backlog_count > 0) {
+        // Batches never wrap around the end of the ring
+        int count = backlog_count;
+        if (count > INGEST_BACKLOG - backlog_head) {
+            count = INGEST_BACKLOG - backlog_head;
+        }
+        if (count > sched_config.batch_size) {
+            count = sched_config.batch_size;
+        }
+
+        int queued = queue_jobs(&backlog[backlog_head], count, scheduler_pid, NULL);
+        if (queued == 0) {
+            return; // Queue is full; wait for processes to finish
+        }
+        backlog_head = (backlog_head + queued) % INGEST_BACKLOG;
+        backlog_count -= queued;
+    }
+}
+
+// Headless front-end: read job specs in bulk from stdin, a file or a FIFO and enqueue them in batches
+void run_batch_ingest(pid_t scheduler_pid, int legacy_priority) {
+    static struct LineReader reader;
+    int fd = STDIN_FILENO;
+    int input_done = 0;
+    int printed = 0;
+    long spec_number = 0;
+
+    if (strcmp(sched_config.input, "-") != 0) {
+        fd = open(sched_config.input, O_RDONLY);
+        if (fd == -1) {
+            perror(sched_config.input);
+            return;
+        }
+    }
+    line_reader_init(&reader, fd);
+
+    // SIGCHLD is only delivered inside ppoll, so queue room is always re-checked after a wake-up
+    sigset_t block, wait_mask;
+    sigemptyset(&block);
+    sigaddset(&block, SIGCHLD);
+    sigprocmask(SIG_BLOCK, &block, &wait_mask);
+    sigdelset(&wait_mask, SIGCHLD);
+    terminated_queue->draining = 1; // Task workers keep to what this loop has printed
+
+    while (1) {
+        if (!input_done && parse_input(&reader, legacy_priority, &spec_number) == -1) {
+            input_done = 1;
+        }
+        flush_backlog(scheduler_pid);
+        drain_terminated_queue(&printed);
+        fflush(stdout);
+
+        if (input_done && backlog_count == 0) {
+            break;
+        }
+
+        // Read more input only while the backlog has space; otherwise just wait for exits
+        int want_input = !input_done && backlog_count < INGEST_BACKLOG;
+        struct pollfd pfd = { fd, POLLIN, 0 };
+        if (ppoll(&pfd, want_input ? 1 : 0, NULL, &wait_mask) == -1) {
+            if (errno != EINTR) {
+                perror("ppoll");
+                break;
+            }
+            continue;
+        }
+        if (want_input && pfd.revents != 0) {
+            int n = line_reader_fill(&reader);
+            if (n == -1 && errno != EINTR && errno != EAGAIN) {
+                perror("read");
+                input_done = 1;
+            }
+        }
+    }
+
+    if (fd != STDIN_FILENO) {
+        close(fd);
+    }
+
+    // Keep reporting completions until every queued process has finished
+    while (scheduler_queue->rear >= 0 || tasks_outstanding() > 0) {
+        sigsuspend(&wait_mask);
+        drain_terminated_queue(&printed);
+        fflush(stdout);
+    }
+    drain_terminated_queue(&printed); // The last task records may land after the last wake-up's drain
+    sigprocmask(SIG_UNBLOCK, &block, NULL);
+    printf("Processed %ld job spec(s), %d process(es) terminated\n", spec_number, terminated_queue->rear + 1);
+    print_tenant_usage();
+    print_deadline_summary();
+    print_memory_summary();
+    print_dispatch_summary();
+    print_counter_summary();
+    print_task_summary();
+}
@@ -0,0 +1,209 @@
+#include "../include/command.h"
+#include "../include/daemon.h"
+#include "../include/snapshot.h"
+#include <errno.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+// Function to print client usage
+static void print_usage(const char *prog) {
+    printf("Usage: %s [-s socket] submit [options] <program> [args...]\n", prog);
+    printf("       %s [-s socket] status [pid]\n", prog);
+    printf("       %s -m /name status [pid]   (read a --snapshot export; no socket, no lock)\n", prog);
+    printf("       %s [-s socket] cancel <pid>\n", prog);
+    printf("       %s [-s socket] slots [N|auto]\n", prog);
+    printf("       %s [-s socket] shutdown\n", prog);
+    printf("       %s [-s socket] -    (send request lines from stdin, pipelined)\n", prog);
+}
+
+// Function to build one request line from command-line words; submit arguments are quoted
+static int build_request(int argc, char *argv[], char *out, size_t size) {
+    if (strcmp(argv[0], "submit") == 0) {
+        static struct Command cmd;
+        if (argc - 1 > MAX_ARGS) {
+            return -1;
+        }
+        memset(&cmd, 0, sizeof(cmd));
+        for (int i = 1; i < argc; i++) {
+            cmd.argv[cmd.argc++] = argv[i];
+        }
+        strcpy(out, "submit ");
+        if (format_command(&cmd, out + 7, size - 8) == -1) {
+            return -1;
+        }
+    } else {
+        size_t used = 0;
+        for (int i = 0; i < argc; i++) {
+            int n = snprintf(out + used, size - used, "%s%s", i ? " " : "", argv[i]);
+            if (n < 0 || (size_t)n >= size - used - 1) {
+                return -1;
+            }
+            used += n;
+        }
+    }
+    strcat(out, "\n");
+    return 0;
+}
+
+// Function to answer "status [pid]" straight from an exported status snapshot; the scheduler is never
+// contacted, so this can be polled as often as wanted
+static int snapshot_status(const char *name, int argc, char *argv[]) {
+    static struct SchedulerSnapshot snapshot;
+    int pid = 0;
+    int count = 0;
+
+    if (strcmp(argv[0], "status") != 0 || argc > 2 || (argc == 2 && sscanf(argv[1], "%d", &pid) != 1)) {
+        fprintf(stderr, "Only status [pid] can be read from a snapshot\n");
+        return 2;
+    }
+    const struct SchedulerSnapshot *shared = attach_snapshot(name);
+    if (shared == NULL) {
+        return 2;
+    }
+    if (read_snapshot(shared, &snapshot) == -1) {
+        printf("error status unavailable\n");
+        return 1;
+    }
+
+    printf("queue tick %lld slots %d running %d waiting %d blocked %d finished %lld\n", snapshot.tick,
+           snapshot.ncpu, snapshot.running, snapshot.waiting, snapshot.blocked, snapshot.terminated);
+    for (int i = 0; i < snapshot.job_count; i++) {
+        struct JobSnapshot *job = &snapshot.jobs[i];
+        if (pid == 0 || job->pid == pid) {
+            char counters[48];
+            format_job_counters(job, counters, sizeof(counters));
+            printf("job %d %s %d %s %lld %s %s\n", (int)job->pid, snapshot_state_name(job), job->priority,
+                   job->tenant, job->cpu_ms, counters, job->command);
+            count++;
+        }
+    }
+    if (pid != 0 && count == 0) {
+        printf("error no job with pid %d\n", pid);
+        return 1;
+    }
+    printf("ok %d\n", count);
+    return 0;
+}
+
+// Thin client for the scheduler daemon: sends requests and prints the replies
+int main(int argc, char *argv[]) {
+    const char *path = DEFAULT_SOCKET_PATH;
+    static char request[MAX_LINE + 16];
+    static char input[LINE_READER_SIZE];
+    size_t input_len = 0, input_sent = 0;
+    const char *snapshot = NULL;
+    int from_stdin = 0, stdin_done = 0;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "+s:m:h")) != -1) {
+        if (opt == 's') {
+            path = optarg;
+        } else if (opt == 'm') {
+            snapshot = optarg;
+        } else {
+            print_usage(argv[0]);
+            return opt == 'h' ? 0 : 2;
+        }
+    }
+    if (optind == argc) {
+        print_usage(argv[0]);
+        return 2;
+    }
+    if (snapshot != NULL) {
+        return snapshot_status(snapshot, argc - optind, argv + optind);
+    }
+    if (strcmp(argv[optind], "-") == 0) {
+        from_stdin = 1;
+    } else if (build_request(argc - optind, argv + optind, request, sizeof(request)) == -1) {
+        fprintf(stderr, "Request too long\n");
+        return 2;
+    } else {
+        input_len = strlen(request);
+        memcpy(input, request, input_len);
+        stdin_done = 1;
+    }
+
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "Socket path too long: %s\n", path);
+        return 2;
+    }
+    strcpy(addr.sun_path, path);
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd == -1 || connect(fd, (struct sockaddr *)&addr, sizeof(addr)) == -1) {
+        perror(path);
+        return 2;
+    }
+
+    // Requests and replies flow at the same time so long pipelines never deadlock
+    int failed = 0, write_open = 1;
+    char reply[LINE_READER_SIZE];
+    size_t reply_len = 0;
+    while (1) {
+        if (from_stdin && !stdin_done && input_sent == input_len) {
+            input_sent = input_len = 0;
+        }
+        if (write_open && stdin_done && input_sent == input_len) {
+            shutdown(fd, SHUT_WR); // Everything sent; the daemon closes after the last reply
+            write_open = 0;
+        }
+
+        struct pollfd pfds[2] = { { fd, POLLIN, 0 }, { STDIN_FILENO, 0, 0 } };
+        if (write_open && input_sent < input_len) {
+            pfds[0].events |= POLLOUT;
+        }
+        if (from_stdin && !stdin_done && input_len < sizeof(input)) {
+            pfds[1].events = POLLIN;
+        }
+        if (poll(pfds, 2, -1) == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            perror("poll");
+            return 2;
+        }
+
+        if (pfds[1].revents != 0) {
+            ssize_t n = read(STDIN_FILENO, input + input_len, sizeof(input) - input_len);
+            if (n <= 0) {
+                stdin_done = 1;
+            } else {
+                input_len += n;
+            }
+        }
+        if (pfds[0].revents & POLLOUT) {
+            ssize_t n = send(fd, input + input_sent, input_len - input_sent, MSG_NOSIGNAL);
+            if (n == -1 && errno != EINTR && errno != EAGAIN) {
+                perror("send");
+                return 2;
+            }
+            if (n > 0) {
+                input_sent += n;
+            }
+        }
+        if (pfds[0].revents & (POLLIN | POLLHUP | POLLERR)) {
+            ssize_t n = recv(fd, reply + reply_len, sizeof(reply) - reply_len, 0);
+            if (n <= 0) {
+                break;
+            }
+            reply_len += n;
+
+            // Print whole reply lines; note any that report an error
+            char *start = reply, *newline;
+            while ((newline = memchr(start, '\n', reply_len - (start - reply))) != NULL) {
+                if (strncmp(start, "error", 5) == 0) {
+                    failed = 1;
+                }
+                fwrite(start, 1, newline - start + 1, stdout);
+                start = newline + 1;
+            }
+            reply_len -= start - reply;
+            memmove(reply, start, reply_len);
+        }
+    }
+    close(fd);
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,568 @@
+#include "../include/command.h"
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/wait.h>
+
+// Token types produced by the command line tokenizer
+enum {
+    TOK_END,
+    TOK_WORD,
+    TOK_PIPE,
+    TOK_IN,
+    TOK_OUT,
+    TOK_APPEND,
+    TOK_ERR,
+    TOK_ERR_APPEND,
+    TOK_ERR_TO_OUT,
+    TOK_ERROR
+};
+
+// Function to read the next token; quotes and backslashes are removed from words
+static int next_token(const char **p, char *out, size_t size) {
+    const char *s = *p;
+
+    while (isspace((unsigned char)*s)) {
+        s++;
+    }
+    if (*s == '\0') {
+        *p = s;
+        return TOK_END;
+    }
+
+    // Operators
+    if (*s == '|') {
+        *p = s + 1;
+        return TOK_PIPE;
+    }
+    if (*s == '<') {
+        *p = s + 1;
+        return TOK_IN;
+    }
+    if (*s == '>') {
+        if (s[1] == '>') {
+            *p = s + 2;
+            return TOK_APPEND;
+        }
+        *p = s + 1;
+        return TOK_OUT;
+    }
+    if (s[0] == '2' && s[1] == '>') {
+        if (s[2] == '&' && s[3] == '1') {
+            *p = s + 4;
+            return TOK_ERR_TO_OUT;
+        }
+        if (s[2] == '>') {
+            *p = s + 3;
+            return TOK_ERR_APPEND;
+        }
+        *p = s + 2;
+        return TOK_ERR;
+    }
+
+    // Words, with '...' and "..." quoting and backslash escapes
+    size_t n = 0;
+    char quote = 0;
+    while (*s != '\0') {
+        if (quote) {
+            if (*s == quote) {
+                quote = 0;
+                s++;
+                continue;
+            }
+            if (quote == '"' && *s == '\\' && (s[1] == '"' || s[1] == '\\')) {
+                s++;
+            }
+        } else {
+            if (isspace((unsigned char)*s) || *s == '|' || *s == '<' || *s == '>') {
+                break;
+            }
+            if (*s == '\'' || *s == '"') {
+                quote = *s++;
+                continue;
+            }
+            if (*s == '\\' && s[1] != '\0') {
+                s++;
+            }
+        }
+        if (n + 1 >= size) {
+            fprintf(stderr, "Command too long\n");
+            return TOK_ERROR;
+        }
+        out[n++] = *s++;
+    }
+    if (quote) {
+        fprintf(stderr, "Unterminated quote\n");
+        return TOK_ERROR;
+    }
+    out[n] = '\0';
+    *p = s;
+    return TOK_WORD;
+}
+
+// Function to check whether a word is a NAME=value assignment
+static int is_assignment(const char *word) {
+    if (!isalpha((unsigned char)word[0]) && word[0] != '_') {
+        return 0;
+    }
+    for (const char *c = word; *c != '\0'; c++) {
+        if (*c == '=') {
+            return 1;
+        }
+        if (!isalnum((unsigned char)*c) && *c != '_') {
+            return 0;
+        }
+    }
+    return 0;
+}
+
+// Function to copy a word into the command's own string storage
+static char *store_word(struct Command *cmd, size_t *used, const char *word) {
+    size_t len = strlen(word) + 1;
+    if (*used + len > sizeof(cmd->buf)) {
+        fprintf(stderr, "Command too long\n");
+        return NULL;
+    }
+    char *dest = cmd->buf + *used;
+    memcpy(dest, word, len);
+    *used += len;
+    return dest;
+}
+
+// Function to reset a command before parsing into it
+static void reset_command(struct Command *cmd) {
+    cmd->argc = 0;
+    cmd->envc = 0;
+    cmd->argv[0] = NULL;
+    cmd->env[0] = NULL;
+    cmd->in_file = NULL;
+    cmd->out_file = NULL;
+    cmd->err_file = NULL;
+    cmd->out_append = 0;
+    cmd->err_append = 0;
+    cmd->err_to_out = 0;
+    cmd->dir = NULL;
+}
+
+// Function to parse a line into at most max commands joined with '|'
+static int parse_commands(const char *line, struct Command *cmds, int max) {
+    char word[MAX_LINE];
+    const char *p = line;
+    int count = 0;
+    size_t used = 0;
+    int pending = TOK_WORD; // Redirection still waiting for its file name
+    struct Command *cmd = &cmds[0];
+
+    reset_command(cmd);
+    while (1) {
+        int tok = next_token(&p, word, sizeof(word));
+        if (tok == TOK_ERROR) {
+            return -1;
+        }
+
+        if (pending != TOK_WORD) {
+            if (tok != TOK_WORD) {
+                fprintf(stderr, "Syntax error: missing file name for redirection\n");
+                return -1;
+            }
+            char *file = store_word(cmd, &used, word);
+            if (file == NULL) {
+                return -1;
+            }
+            if (pending == TOK_IN) {
+                cmd->in_file = file;
+            } else if (pending == TOK_OUT || pending == TOK_APPEND) {
+                cmd->out_file = file;
+                cmd->out_append = (pending == TOK_APPEND);
+            } else {
+                cmd->err_file = file;
+                cmd->err_append = (pending == TOK_ERR_APPEND);
+            }
+            pending = TOK_WORD;
+            continue;
+        }
+
+        switch (tok) {
+            case TOK_WORD: {
+                char *stored = store_word(cmd, &used, word);
+                if (stored == NULL) {
+                    return -1;
+                }
+                if (cmd->argc == 0 && is_assignment(word)) {
+                    if (cmd->envc == MAX_ENV) {
+                        fprintf(stderr, "Too many environment assignments\n");
+                        return -1;
+                    }
+                    cmd->env[cmd->envc++] = stored;
+                    cmd->env[cmd->envc] = NULL;
+                } else {
+                    if (cmd->argc == MAX_ARGS) {
+                        fprintf(stderr, "Too many arguments\n");
+                        return -1;
+                    }
+                    cmd->argv[cmd->argc++] = stored;
+                    cmd->argv[cmd->argc] = NULL;
+                }
+                break;
+            }
+            case TOK_PIPE:
+                if (cmd->argc == 0) {
+                    fprintf(stderr, "Syntax error near '|'\n");
+                    return -1;
+                }
+                if (count + 1 == max) {
+                    fprintf(stderr, max == 1 ? "Pipes are not supported here\n" : "Too many commands in pipeline\n");
+                    return -1;
+                }
+                cmd = &cmds[++count];
+                used = 0;
+                reset_command(cmd);
+                break;
+            case TOK_ERR_TO_OUT:
+                cmd->err_to_out = 1;
+                break;
+            case TOK_END:
+                if (cmd->argc == 0) {
+                    if (count > 0 || cmd->envc > 0 || cmd->in_file || cmd->out_file || cmd->err_file) {
+                        fprintf(stderr, "Syntax error: missing command\n");
+                        return -1;
+                    }
+                    return 0;
+                }
+                return count + 1;
+            default:
+                pending = tok;
+                break;
+        }
+    }
+}
+
+// Function to parse a single command; returns argc (0 for an empty line) or -1
+int parse_command(const char *line, struct Command *cmd) {
+    int count = parse_commands(line, cmd, 1);
+    if (count <= 0) {
+        return count;
+    }
+    return cmd->argc;
+}
+
+// Function to parse a pipeline; returns the number of commands (0 for an empty line) or -1
+int parse_pipeline(const char *line, struct Pipeline *pipeline) {
+    pipeline->count = parse_commands(line, pipeline->cmds, MAX_PIPELINE);
+    return pipeline->count;
+}
+
+// Function to append a single-quoted word to a command line being formatted
+static int append_quoted(char *out, size_t size, size_t *used, const char *prefix, const char *word) {
+    size_t n = *used;
+
+    for (const char *c = prefix; *c != '\0'; c++) {
+        if (n + 1 >= size) {
+            return -1;
+        }
+        out[n++] = *c;
+    }
+    if (n + 2 >= size) {
+        return -1;
+    }
+    out[n++] = '\'';
+    for (const char *c = word; *c != '\0'; c++) {
+        if (*c == '\'') {
+            // Close the quote, add an escaped quote and reopen
+            if (n + 5 >= size) {
+                return -1;
+            }
+            memcpy(out + n, "'\\''", 4);
+            n += 4;
+        } else {
+            if (n + 2 >= size) {
+                return -1;
+            }
+            out[n++] = *c;
+        }
+    }
+    out[n++] = '\'';
+    out[n] = '\0';
+    *used = n;
+    return 0;
+}
+
+// Function to turn a parsed command back into a line that parse_command reads identically; -1 if too long
+int format_command(const struct Command *cmd, char *out, size_t size) {
+    size_t used = 0;
+    int result = 0;
+
+    out[0] = '\0';
+    for (int i = 0; i < cmd->envc && result == 0; i++) {
+        result = append_quoted(out, size, &used, used ? " " : "", cmd->env[i]);
+    }
+    for (int i = 0; i < cmd->argc && result == 0; i++) {
+        result = append_quoted(out, size, &used, used ? " " : "", cmd->argv[i]);
+    }
+    if (cmd->in_file != NULL && result == 0) {
+        result = append_quoted(out, size, &used, " < ", cmd->in_file);
+    }
+    if (cmd->out_file != NULL && result == 0) {
+        result = append_quoted(out, size, &used, cmd->out_append ? " >> " : " > ", cmd->out_file);
+    }
+    if (cmd->err_file != NULL && result == 0) {
+        result = append_quoted(out, size, &used, cmd->err_append ? " 2>> " : " 2> ", cmd->err_file);
+    }
+    if (cmd->err_to_out && result == 0) {
+        result = used + 5 < size ? 0 : -1;
+        if (result == 0) {
+            strcpy(out + used, " 2>&1");
+            used += 5;
+        }
+    }
+    return result;
+}
+
+// Function to point a standard descriptor at a file
+static void redirect_file(const char *path, int flags, int target) {
+    int fd = open(path, flags, 0644);
+    if (fd == -1) {
+        perror(path);
+        _exit(EXIT_FAILURE);
+    }
+    if (dup2(fd, target) == -1) {
+        perror("dup2 error");
+        _exit(EXIT_FAILURE);
+    }
+    close(fd);
+}
+
+// Function run in the child: set up descriptors and environment, then exec. err_fd may equal out_fd.
+static void exec_command(const struct Command *cmd, int flags, int in_fd, int out_fd, int err_fd) {
+    sigset_t none;
+    sigemptyset(&none);
+    sigprocmask(SIG_SETMASK, &none, NULL);
+
+    if ((flags & SPAWN_SETSID) && setsid() == -1) {
+        perror("setsid error");
+        _exit(EXIT_FAILURE);
+    }
+    if ((flags & SPAWN_PGROUP) && setpgid(0, 0) == -1) {
+        perror("setpgid error");
+        _exit(EXIT_FAILURE);
+    }
+    if (flags & SPAWN_STOPPED) {
+        // Park until the scheduler hands out the first time slice
+        raise(SIGSTOP);
+    }
+
+    if (in_fd >= 0) {
+        dup2(in_fd, STDIN_FILENO);
+        close(in_fd);
+    }
+    if (out_fd >= 0) {
+        dup2(out_fd, STDOUT_FILENO);
+    }
+    if (err_fd >= 0) {
+        dup2(err_fd, STDERR_FILENO);
+    }
+    if (out_fd > STDERR_FILENO) {
+        close(out_fd);
+    }
+    if (err_fd > STDERR_FILENO && err_fd != out_fd) {
+        close(err_fd);
+    }
+    for (int i = 0; i < cmd->envc; i++) {
+        putenv(cmd->env[i]);
+    }
+    if (cmd->dir != NULL && chdir(cmd->dir) == -1) {
+        perror(cmd->dir);
+        _exit(127);
+    }
+    if (cmd->in_file) {
+        redirect_file(cmd->in_file, O_RDONLY, STDIN_FILENO);
+    }
+    if (cmd->out_file) {
+        redirect_file(cmd->out_file, O_WRONLY | O_CREAT | (cmd->out_append ? O_APPEND : O_TRUNC), STDOUT_FILENO);
+    }
+    if (cmd->err_to_out) {
+        dup2(STDOUT_FILENO, STDERR_FILENO);
+    }
+    if (cmd->err_file) {
+        redirect_file(cmd->err_file, O_WRONLY | O_CREAT | (cmd->err_append ? O_APPEND : O_TRUNC), STDERR_FILENO);
+    }
+
+    execvp(cmd->argv[0], cmd->argv);
+    perror("Exec error");
+    _exit(127);
+}
+
+// Function to wait until a child started with SPAWN_STOPPED has parked itself; returns 1 once it has
+// stopped, 0 if it died first (reaped here, or already reaped by a SIGCHLD handler)
+int wait_for_stop(pid_t pid) {
+    int status;
+    pid_t result;
+    while ((result = waitpid(pid, &status, WUNTRACED)) == -1 && errno == EINTR) {
+    }
+    return result == pid && WIFSTOPPED(status);
+}
+
+// Function to fork and exec a parsed command; returns the child's PID or -1
+pid_t spawn_command(const struct Command *cmd, int flags) {
+    pid_t pid = fork();
+    if (pid < 0) {
+        perror("Fork error");
+        return -1;
+    }
+    if (pid == 0) {
+        exec_command(cmd, flags, -1, -1, -1);
+    }
+    if (flags & SPAWN_PGROUP) {
+        setpgid(pid, pid); // Also from this side, so the group exists whichever runs first
+    }
+    if ((flags & SPAWN_STOPPED) && !(flags & SPAWN_NOWAIT)) {
+        wait_for_stop(pid);
+    }
+    return pid;
+}
+
+// Function to fork and exec a parsed command with its stdout and stderr on a new pipe, so its output
+// never waits on a terminal. Returns the child's PID and stores the pipe's read end in *output, or -1.
+// Redirections in the command itself still take precedence.
+pid_t spawn_captured(const struct Command *cmd, int flags, int *output) {
+    int pipe_fd[2];
+    if (pipe2(pipe_fd, O_CLOEXEC) == -1) {
+        perror("Pipe error");
+        return -1;
+    }
+
+    pid_t pid = fork();
+    if (pid < 0) {
+        perror("Fork error");
+        close(pipe_fd[0]);
+        close(pipe_fd[1]);
+        return -1;
+    }
+    if (pid == 0) {
+        exec_command(cmd, flags, -1, pipe_fd[1], pipe_fd[1]);
+    }
+    close(pipe_fd[1]);
+    if (flags & SPAWN_PGROUP) {
+        setpgid(pid, pid);
+    }
+    if ((flags & SPAWN_STOPPED) && !(flags & SPAWN_NOWAIT)) {
+        wait_for_stop(pid);
+    }
+    *output = pipe_fd[0];
+    return pid;
+}
+
+// Function to start every stage of a pipeline; returns how many stages were started
+int spawn_pipeline(const struct Pipeline *pipeline, pid_t pids[], int flags) {
+    int in_fd = -1;
+    int started = 0;
+
+    for (int i = 0; i < pipeline->count; i++) {
+        int pipe_fd[2] = { -1, -1 };
+        if (i + 1 < pipeline->count && pipe(pipe_fd) == -1) {
+            perror("Pipe error");
+            break;
+        }
+
+        pid_t pid = fork();
+        if (pid < 0) {
+            perror("Fork error");
+            if (pipe_fd[0] >= 0) {
+                close(pipe_fd[0]);
+                close(pipe_fd[1]);
+            }
+            break;
+        }
+        if (pid == 0) {
+            if (pipe_fd[0] >= 0) {
+                close(pipe_fd[0]);
+            }
+            exec_command(&pipeline->cmds[i], flags, in_fd, pipe_fd[1], -1);
+        }
+
+        pids[started++] = pid;
+        if (in_fd >= 0) {
+            close(in_fd);
+        }
+        if (pipe_fd[1] >= 0) {
+            close(pipe_fd[1]);
+        }
+        in_fd = pipe_fd[0];
+    }
+    if (in_fd >= 0) {
+        close(in_fd);
+    }
+
+    if ((flags & SPAWN_STOPPED) && !(flags & SPAWN_NOWAIT)) {
+        for (int i = 0; i < started; i++) {
+            wait_for_stop(pids[i]);
+        }
+    }
+    return started;
+}
+
+// Function to initialise a line reader on a descriptor
+void line_reader_init(struct LineReader *reader, int fd) {
+    reader->fd = fd;
+    reader->start = 0;
+    reader->len = 0;
+    reader->eof = 0;
+}
+
+// Function to read whatever input is available; returns bytes read, 0 at EOF, -1 on error
+int line_reader_fill(struct LineReader *reader) {
+    if (reader->start > 0) {
+        memmove(reader->buf, reader->buf + reader->start, reader->len - reader->start);
+        reader->len -= reader->start;
+        reader->start = 0;
+    }
+    if (reader->len == sizeof(reader->buf)) {
+        errno = ENOBUFS; // Full: the caller must take a line first
+        return -1;
+    }
+
+    ssize_t n = read(reader->fd, reader->buf + reader->len, sizeof(reader->buf) - reader->len);
+    if (n == 0) {
+        reader->eof = 1;
+    } else if (n > 0) {
+        reader->len += n;
+    }
+    return (int)n;
+}
+
+// Function to take the next complete line; returns 1 for a line, 0 if more input is needed, -1 at EOF
+int line_reader_next(struct LineReader *reader, char *line, size_t size) {
+    char *begin = reader->buf + reader->start;
+    size_t avail = reader->len - reader->start;
+    char *newline = memchr(begin, '\n', avail);
+    size_t take;
+    size_t length;
+
+    if (newline != NULL) {
+        length = newline - begin;
+        take = length + 1;
+    } else if (avail > 0 && (reader->eof || (reader->start == 0 && reader->len == sizeof(reader->buf)))) {
+        // Last unterminated line, or a line longer than the whole buffer
+        length = avail;
+        take = avail;
+    } else {
+        return reader->eof ? -1 : 0;
+    }
+
+    if (length > 0 && begin[length - 1] == '\r') {
+        length--;
+    }
+    if (length >= size) {
+        length = size - 1;
+    }
+    memcpy(line, begin, length);
+    line[length] = '\0';
+
+    reader->start += take;
+    if (reader->start == reader->len) {
+        reader->start = 0;
+        reader->len = 0;
+    }
+    return 1;
+}
@@ -0,0 +1,431 @@
+#include "../include/scheduler.h"
+#include "../include/globals.h"
+#include "../include/daemon.h"
+#include <ctype.h>
+#include <getopt.h>
+
+// Function to print command-line usage for the standalone schedulers
+static void print_usage(const char *prog) {
+    printf("Usage: %s [options]\n", prog);
+    printf("  -n, --ncpu N        Number of CPUs to schedule on\n");
+    printf("  -t, --tslice MS     Time quantum in milliseconds\n");
+    printf("  -c, --config FILE   Read 'key = value' settings from FILE\n");
+    printf("  -H, --headless      Read job specs from input instead of running the shell\n");
+    printf("  -i, --input PATH    Job spec source for headless mode: '-', a file or a FIFO\n");
+    printf("  -b, --binary        Job specs are length-prefixed frames instead of lines\n");
+    printf("      --batch N       Maximum jobs handed to the scheduler per wake-up\n");
+    printf("  -w, --weight G=W    Fair-share weight W for user/group G (repeatable)\n");
+    printf("  -P, --policy NAME   Scheduling policy: rr, priority, edf, srpt or sjf\n");
+    printf("      --admission M   Infeasible deadline jobs under edf: reject or defer\n");
+    printf("  -m, --memory-aware  Size rounds by memory/IO pressure and job working sets\n");
+    printf("      --psi-limit PCT Stall percentage (avg10) that halves concurrency (default %d)\n", DEFAULT_PSI_LIMIT);
+    printf("      --passthrough   Admit up to NCPU jobs and let the kernel share the CPUs\n");
+    printf("  -E, --elastic       Track usable CPUs and other tenants' load; -n becomes the ceiling\n");
+    printf("      --counters      Attach performance counters (IPC, LLC misses, context switches) to each job\n");
+    printf("      --interference MPKI Run jobs with this many LLC misses per 1000 instructions at most one per\n");
+    printf("                          LLC domain at a time (a concurrency cap; jobs are not pinned)\n");
+    printf("  -l, --listen ADDR   Coordinate node agents connecting to [host:]port\n");
+    printf("  -D, --daemon        Serve submit/status/cancel requests on a Unix socket\n");
+    printf("  -S, --socket PATH   Socket for --daemon (default %s)\n", DEFAULT_SOCKET_PATH);
+    printf("      --snapshot NAME Export the status snapshot as shared memory /NAME for schedctl -m\n");
+    printf("      --log-dir DIR   Capture each job's stdout/stderr in DIR/<pid>.log\n");
+    printf("      --log-cap KB    Rotate a job's log at this size (default %d)\n", DEFAULT_LOG_CAP_KB);
+    printf("      --log-keep N    Rotated logs kept per job (default %d)\n", DEFAULT_LOG_KEEP);
+    printf("  -R, --runtime-db F  Load and save the per-command runtime model in file F\n");
+    printf("      --record FILE   Record every submission and exit to a trace for bin/replay\n");
+    printf("  -h, --help          Show this help\n");
+}
+
+// Function to parse a positive integer setting
+static int parse_positive(const char *key, const char *value, int *out) {
+    char *end;
+    long number = strtol(value, &end, 10);
+    if (*value == '\0' || *end != '\0' || number <= 0 || number > INT_MAX) {
+        fprintf(stderr, "Invalid value for %s: %s\n", key, value);
+        return -1;
+    }
+    *out = (int)number;
+    return 0;
+}
+
+// Function to parse a yes/no setting
+static int parse_bool(const char *key, const char *value, int *out) {
+    if (strcmp(value, "1") == 0 || strcmp(value, "yes") == 0 || strcmp(value, "true") == 0 || strcmp(value, "on") == 0) {
+        *out = 1;
+    } else if (strcmp(value, "0") == 0 || strcmp(value, "no") == 0 || strcmp(value, "false") == 0 || strcmp(value, "off") == 0) {
+        *out = 0;
+    } else {
+        fprintf(stderr, "Invalid value for %s: %s\n", key, value);
+        return -1;
+    }
+    return 0;
+}
+
+// Function to apply one setting; shared by configuration files and the command line
+static int apply_setting(const char *key, const char *value) {
+    if (strcmp(key, "ncpu") == 0) {
+        return parse_positive(key, value, &NCPU);
+    } else if (strcmp(key, "elastic") == 0) {
+        return parse_bool(key, value, &sched_config.elastic);
+    } else if (strcmp(key, "tslice") == 0) {
+        return parse_positive(key, value, &TSLICE);
+    } else if (strcmp(key, "headless") == 0) {
+        return parse_bool(key, value, &sched_config.headless);
+    } else if (strcmp(key, "input") == 0) {
+        if (strlen(value) >= sizeof(sched_config.input)) {
+            fprintf(stderr, "Input path too long: %s\n", value);
+            return -1;
+        }
+        strcpy(sched_config.input, value);
+        sched_config.headless = 1;
+        return 0;
+    } else if (strcmp(key, "binary") == 0) {
+        return parse_bool(key, value, &sched_config.binary);
+    } else if (strcmp(key, "batch") == 0) {
+        return parse_positive(key, value, &sched_config.batch_size);
+    } else if (strcmp(key, "policy") == 0) {
+        if (strcmp(value, "rr") == 0) {
+            sched_config.policy = POLICY_RR;
+        } else if (strcmp(value, "priority") == 0) {
+            sched_config.policy = POLICY_PRIORITY;
+        } else if (strcmp(value, "edf") == 0) {
+            sched_config.policy = POLICY_EDF;
+        } else if (strcmp(value, "srpt") == 0) {
+            sched_config.policy = POLICY_SRPT;
+        } else if (strcmp(value, "sjf") == 0) {
+            sched_config.policy = POLICY_SJF;
+        } else {
+            fprintf(stderr, "Unknown policy: %s (expected rr, priority, edf, srpt or sjf)\n", value);
+            return -1;
+        }
+        return 0;
+    } else if (strcmp(key, "admission") == 0) {
+        if (strcmp(value, "reject") == 0) {
+            sched_config.admission = ADMISSION_REJECT;
+        } else if (strcmp(value, "defer") == 0) {
+            sched_config.admission = ADMISSION_DEFER;
+        } else {
+            fprintf(stderr, "Unknown admission mode: %s (expected reject or defer)\n", value);
+            return -1;
+        }
+        return 0;
+    } else if (strcmp(key, "memory_aware") == 0) {
+        return parse_bool(key, value, &sched_config.memory_aware);
+    } else if (strcmp(key, "psi_limit") == 0) {
+        if (parse_positive(key, value, &sched_config.psi_limit) == -1) {
+            return -1;
+        }
+        if (sched_config.psi_limit > 100) {
+            fprintf(stderr, "Invalid value for %s: %s (must be 1-100)\n", key, value);
+            return -1;
+        }
+        return 0;
+    } else if (strcmp(key, "passthrough") == 0) {
+        return parse_bool(key, value, &sched_config.passthrough);
+    } else if (strcmp(key, "counters") == 0) {
+        return parse_bool(key, value, &sched_config.counters);
+    } else if (strcmp(key, "interference") == 0) {
+        if (parse_positive(key, value, &sched_config.interference_mpki) == -1) {
+            return -1;
+        }
+        sched_config.counters = 1; // Placement needs the miss rates
+        return 0;
+    } else if (strcmp(key, "listen") == 0) {
+        if (*value == '\0' || strlen(value) >= sizeof(sched_config.listen)) {
+            fprintf(stderr, "Invalid value for %s: %s\n", key, value);
+            return -1;
+        }
+        strcpy(sched_config.listen, value);
+        return 0;
+    } else if (strcmp(key, "daemon") == 0) {
+        return parse_bool(key, value, &sched_config.daemon);
+    } else if (strcmp(key, "socket") == 0) {
+        if (*value == '\0' || strlen(value) >= sizeof(sched_config.socket)) {
+            fprintf(stderr, "Invalid value for %s: %s\n", key, value);
+            return -1;
+        }
+        strcpy(sched_config.socket, value);
+        return 0;
+    } else if (strcmp(key, "snapshot") == 0) {
+        if (value[0] != '/' || value[1] == '\0' || strchr(value + 1, '/') != NULL ||
+            strlen(value) >= sizeof(sched_config.snapshot)) {
+            fprintf(stderr, "Invalid value for %s: %s (expected /NAME)\n", key, value);
+            return -1;
+        }
+        strcpy(sched_config.snapshot, value);
+        return 0;
+    } else if (strcmp(key, "log_dir") == 0) {
+        if (*value == '\0' || strlen(value) >= sizeof(sched_config.log_dir)) {
+            fprintf(stderr, "Invalid value for %s: %s\n", key, value);
+            return -1;
+        }
+        strcpy(sched_config.log_dir, value);
+        return 0;
+    } else if (strcmp(key, "runtime_db") == 0) {
+        if (*value == '\0' || strlen(value) + 4 >= sizeof(sched_config.runtime_db)) {
+            fprintf(stderr, "Invalid value for %s: %s\n", key, value);
+            return -1;
+        }
+        strcpy(sched_config.runtime_db, value);
+        return 0;
+    } else if (strcmp(key, "record") == 0) {
+        if (*value == '\0' || strlen(value) >= sizeof(sched_config.record)) {
+            fprintf(stderr, "Invalid value for %s: %s\n", key, value);
+            return -1;
+        }
+        strcpy(sched_config.record, value);
+        return 0;
+    } else if (strcmp(key, "log_cap") == 0) {
+        return parse_positive(key, value, &sched_config.log_cap_kb);
+    } else if (strcmp(key, "log_keep") == 0) {
+        if (strcmp(value, "0") == 0) {
+            sched_config.log_keep = 0;
+            return 0;
+        }
+        return parse_positive(key, value, &sched_config.log_keep);
+    } else if (strncmp(key, "weight.", 7) == 0) {
+        return set_tenant_weight(key + 7, value);
+    }
+    fprintf(stderr, "Unknown setting: %s\n", key);
+    return -1;
+}
+
+// Function to load settings from a file of "key = value" lines; '#' starts a comment
+static int load_config_file(const char *path) {
+    FILE *file = fopen(path, "r");
+    if (file == NULL) {
+        perror(path);
+        return -1;
+    }
+
+    char line[MAX_LINE];
+    int line_number = 0;
+    int result = 0;
+    while (fgets(line, sizeof(line), file) != NULL) {
+        line_number++;
+        line[strcspn(line, "#\n")] = '\0';
+
+        char *key = line;
+        while (isspace((unsigned char)*key)) {
+            key++;
+        }
+        if (*key == '\0') {
+            continue;
+        }
+
+        char *eq = strchr(key, '=');
+        if (eq == NULL) {
+            fprintf(stderr, "%s:%d: expected 'key = value'\n", path, line_number);
+            result = -1;
+            break;
+        }
+        char *value = eq + 1;
+        do {
+            *eq-- = '\0';
+        } while (eq >= key && isspace((unsigned char)*eq));
+        while (isspace((unsigned char)*value)) {
+            value++;
+        }
+        char *end = value + strlen(value);
+        while (end > value && isspace((unsigned char)end[-1])) {
+            *--end = '\0';
+        }
+
+        if (apply_setting(key, value) == -1) {
+            fprintf(stderr, "%s:%d: invalid setting\n", path, line_number);
+            result = -1;
+            break;
+        }
+    }
+    fclose(file);
+    return result;
+}
+
+// Function to parse scheduler options; returns 0 to run, 1 after --help, -1 on error
+int parse_scheduler_args(int argc, char *argv[]) {
+    static const struct option options[] = {
+        { "ncpu", required_argument, NULL, 'n' },
+        { "tslice", required_argument, NULL, 't' },
+        { "config", required_argument, NULL, 'c' },
+        { "headless", no_argument, NULL, 'H' },
+        { "input", required_argument, NULL, 'i' },
+        { "binary", no_argument, NULL, 'b' },
+        { "batch", required_argument, NULL, 'B' },
+        { "weight", required_argument, NULL, 'w' },
+        { "policy", required_argument, NULL, 'P' },
+        { "admission", required_argument, NULL, 'A' },
+        { "memory-aware", no_argument, NULL, 'm' },
+        { "psi-limit", required_argument, NULL, 'L' },
+        { "passthrough", no_argument, NULL, 'K' },
+        { "elastic", no_argument, NULL, 'E' },
+        { "counters", no_argument, NULL, 'C' },
+        { "interference", required_argument, NULL, 'I' },
+        { "listen", required_argument, NULL, 'l' },
+        { "daemon", no_argument, NULL, 'D' },
+        { "socket", required_argument, NULL, 'S' },
+        { "snapshot", required_argument, NULL, 'N' },
+        { "log-dir", required_argument, NULL, 'O' },
+        { "log-cap", required_argument, NULL, 'Z' },
+        { "log-keep", required_argument, NULL, 'k' },
+        { "runtime-db", required_argument, NULL, 'R' },
+        { "record", required_argument, NULL, 'T' },
+        { "help", no_argument, NULL, 'h' },
+        { NULL, 0, NULL, 0 }
+    };
+    static const char *short_options = "n:t:c:Hi:bw:P:mEl:DS:R:h";
+    int opt;
+
+    // Configuration files are applied first so the command line can override them
+    while ((opt = getopt_long(argc, argv, short_options, options, NULL)) != -1) {
+        if (opt == '?') {
+            print_usage(argv[0]);
+            return -1;
+        }
+        if (opt == 'c' && load_config_file(optarg) == -1) {
+            return -1;
+        }
+    }
+    if (optind < argc) {
+        fprintf(stderr, "Unexpected argument: %s\n", argv[optind]);
+        return -1;
+    }
+
+    optind = 0;
+    while ((opt = getopt_long(argc, argv, short_options, options, NULL)) != -1) {
+        int result = 0;
+        switch (opt) {
+            case 'n':
+                result = apply_setting("ncpu", optarg);
+                break;
+            case 't':
+                result = apply_setting("tslice", optarg);
+                break;
+            case 'H':
+                sched_config.headless = 1;
+                break;
+            case 'i':
+                result = apply_setting("input", optarg);
+                break;
+            case 'b':
+                sched_config.binary = 1;
+                break;
+            case 'B':
+                result = apply_setting("batch", optarg);
+                break;
+            case 'w': {
+                char *eq = strrchr(optarg, '=');
+                if (eq == NULL) {
+                    fprintf(stderr, "Expected --weight GROUP=WEIGHT\n");
+                    return -1;
+                }
+                *eq = '\0';
+                result = set_tenant_weight(optarg, eq + 1);
+                break;
+            }
+            case 'P':
+                result = apply_setting("policy", optarg);
+                break;
+            case 'A':
+                result = apply_setting("admission", optarg);
+                break;
+            case 'm':
+                sched_config.memory_aware = 1;
+                break;
+            case 'L':
+                result = apply_setting("psi_limit", optarg);
+                break;
+            case 'K':
+                sched_config.passthrough = 1;
+                break;
+            case 'E':
+                sched_config.elastic = 1;
+                break;
+            case 'C':
+                sched_config.counters = 1;
+                break;
+            case 'I':
+                result = apply_setting("interference", optarg);
+                break;
+            case 'l':
+                result = apply_setting("listen", optarg);
+                break;
+            case 'D':
+                sched_config.daemon = 1;
+                break;
+            case 'S':
+                result = apply_setting("socket", optarg);
+                break;
+            case 'N':
+                result = apply_setting("snapshot", optarg);
+                break;
+            case 'O':
+                result = apply_setting("log_dir", optarg);
+                break;
+            case 'Z':
+                result = apply_setting("log_cap", optarg);
+                break;
+            case 'k':
+                result = apply_setting("log_keep", optarg);
+                break;
+            case 'R':
+                result = apply_setting("runtime_db", optarg);
+                break;
+            case 'T':
+                result = apply_setting("record", optarg);
+                break;
+            case 'h':
+                print_usage(argv[0]);
+                return 1;
+        }
+        if (result == -1) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// Function to fill in NCPU and TSLICE that were not configured: prompt interactively, default when headless or a daemon.
+// Unset NCPU defaults to the CPUs the scheduler may use (affinity mask and cgroup quota); in elastic mode it
+// stays unset, so the slot count follows those limits as they change.
+void read_scheduler_settings(void) {
+    // The shell front-end reads fd 0 directly, so stdio must not buffer ahead of it
+    setvbuf(stdin, NULL, _IONBF, 0);
+
+    // A coordinator's CPUs are the slots its agents register; NCPU only bounds EDF admission
+    if (sched_config.listen[0] != '\0') {
+        sched_config.elastic = 0;
+        if (NCPU <= 0) {
+            NCPU = usable_cpus();
+        }
+    }
+    if (sched_config.headless || sched_config.daemon) {
+        if (NCPU <= 0 && !sched_config.elastic) {
+            NCPU = usable_cpus();
+        }
+        if (TSLICE <= 0) {
+            TSLICE = DEFAULT_TSLICE;
+        }
+        return;
+    }
+
+    while (NCPU <= 0 && !sched_config.elastic) {
+        printf("Enter the number of CPUs: ");
+        if (scanf("%d", &NCPU) != 1) {
+            if (feof(stdin)) {
+                exit(1);
+            }
+            scanf("%*s");
+            NCPU = 0;
+        }
+    }
+    while (TSLICE <= 0) {
+        printf("Enter the time quantum (TSLICE) in milliseconds: ");
+        if (scanf("%d", &TSLICE) != 1) {
+            if (feof(stdin)) {
+                exit(1);
+            }
+            scanf("%*s");
+            TSLICE = 0;
+        }
+    }
+}
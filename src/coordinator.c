@@ -0,0 +1,281 @@
+#include "../include/scheduler.h"
+#include "../include/globals.h"
+#include "../include/policy.h"
+#include "../include/protocol.h"
+#include <poll.h>
+#include <sys/socket.h>
+#include <netinet/tcp.h>
+
+#define MAX_AGENTS 16
+
+// Structure for a connected node agent
+struct Agent {
+    int fd;                     // -1 for a free entry
+    struct LineReader reader;
+    char host[64];
+    int slots;                  // CPU slots registered by the node, 0 until it says hello
+    int busy;                   // Slots given to jobs this round
+};
+
+static struct Agent agents[MAX_AGENTS];
+static int listen_fd = -1;
+
+// Function to open the coordinator's listening socket
+static void open_listener(void) {
+    struct sockaddr_in addr;
+    int on = 1;
+
+    if (parse_endpoint(sched_config.listen, &addr) == -1) {
+        fprintf(stderr, "Invalid listen address: %s\n", sched_config.listen);
+        exit(1);
+    }
+    listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (listen_fd == -1) {
+        perror("socket");
+        exit(1);
+    }
+    setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    if (bind(listen_fd, (struct sockaddr *)&addr, sizeof(addr)) == -1 || listen(listen_fd, MAX_AGENTS) == -1) {
+        perror(sched_config.listen);
+        exit(1);
+    }
+    for (int a = 0; a < MAX_AGENTS; a++) {
+        agents[a].fd = -1;
+    }
+}
+
+// Function to accept a new agent connection
+static void accept_agent(void) {
+    int fd = accept(listen_fd, NULL, NULL);
+    int on = 1;
+
+    if (fd == -1) {
+        return;
+    }
+    for (int a = 0; a < MAX_AGENTS; a++) {
+        if (agents[a].fd == -1) {
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+            agents[a].fd = fd;
+            agents[a].slots = 0;
+            agents[a].busy = 0;
+            strcpy(agents[a].host, "?");
+            line_reader_init(&agents[a].reader, fd);
+            return;
+        }
+    }
+    fprintf(stderr, "Too many agents; refusing connection\n");
+    close(fd);
+}
+
+// Function to drop an agent; its jobs are lost with it. Call with the queue lock held.
+static void drop_agent(int a) {
+    int lost = 0;
+    for (int i = scheduler_queue->rear; i >= 0; i--) {
+        if (i <= scheduler_queue->rear && scheduler_queue->processes[i].node == a) {
+            retire_process(i, scheduler_queue->processes[i].total_execution_time, -1);
+            lost++;
+        }
+    }
+    printf("Agent %s disconnected; %d job(s) lost\n", agents[a].host, lost);
+    fflush(stdout);
+    close(agents[a].fd);
+    agents[a].fd = -1;
+    if (lost > 0) {
+        kill(getppid(), SIGCHLD); // Let the front-end see the queue shrink
+    }
+}
+
+// Function to act on one message from an agent; call with the queue lock held
+static void handle_agent_message(int a, const struct Message *msg) {
+    int i = msg->type == MSG_HELLO ? -1 : find_process((pid_t)msg->job);
+
+    switch (msg->type) {
+        case MSG_HELLO:
+            if (msg->a != PROTOCOL_VERSION) {
+                fprintf(stderr, "Agent %s speaks protocol %u, expected %d\n", msg->text, msg->a, PROTOCOL_VERSION);
+                drop_agent(a);
+                return;
+            }
+            strncpy(agents[a].host, msg->text, sizeof(agents[a].host) - 1);
+            agents[a].host[sizeof(agents[a].host) - 1] = '\0';
+            agents[a].slots = (int)msg->b;
+            printf("Agent %s registered %d slot(s)\n", agents[a].host, agents[a].slots);
+            fflush(stdout);
+            break;
+        case MSG_STARTED:
+            if (i != -1) {
+                scheduler_queue->processes[i].remote_pid = (pid_t)msg->a;
+            }
+            break;
+        case MSG_USAGE:
+            if (i != -1 && msg->a > scheduler_queue->processes[i].total_execution_time) {
+                struct Process *process = &scheduler_queue->processes[i];
+                scheduler_queue->tenants[process->tenant].usage += msg->a - process->total_execution_time;
+                process->total_execution_time = msg->a;
+            }
+            break;
+        case MSG_EXIT:
+            if (i != -1) {
+                retire_process(i, msg->b, (int)msg->a);
+                kill(getppid(), SIGCHLD); // The front-end waits for SIGCHLD to notice finished jobs
+            }
+            break;
+        default:
+            fprintf(stderr, "Agent %s sent unexpected message type %d\n", agents[a].host, (int)msg->type);
+            break;
+    }
+}
+
+// Function to serve agent connections and messages until the given monotonic time
+static void serve_agents(long long until) {
+    struct pollfd pfds[MAX_AGENTS + 1];
+    int index[MAX_AGENTS + 1];
+
+    while (1) {
+        long long left = until - monotonic_ms();
+        if (left <= 0) {
+            return;
+        }
+
+        int n = 0;
+        pfds[n].fd = listen_fd;
+        pfds[n].events = POLLIN;
+        index[n++] = -1;
+        for (int a = 0; a < MAX_AGENTS; a++) {
+            if (agents[a].fd != -1) {
+                pfds[n].fd = agents[a].fd;
+                pfds[n].events = POLLIN;
+                index[n++] = a;
+            }
+        }
+        if (poll(pfds, n, (int)left) <= 0) {
+            continue;
+        }
+
+        for (int k = 0; k < n; k++) {
+            if (pfds[k].revents == 0) {
+                continue;
+            }
+            if (index[k] == -1) {
+                accept_agent();
+                continue;
+            }
+
+            int a = index[k];
+            int filled = line_reader_fill(&agents[a].reader);
+            lock_scheduler_queue();
+            struct Message msg;
+            int ready;
+            while ((ready = next_message(&agents[a].reader, &msg)) == 1 && agents[a].fd != -1) {
+                handle_agent_message(a, &msg);
+            }
+            if (agents[a].fd != -1 && (ready == -1 || (filled == -1 && errno != EINTR))) {
+                drop_agent(a);
+            }
+            unlock_scheduler_queue();
+        }
+    }
+}
+
+// Function to choose the agent with the most free slots, or -1 if all are busy
+static int least_loaded_agent(void) {
+    int best = -1;
+    for (int a = 0; a < MAX_AGENTS; a++) {
+        if (agents[a].fd == -1 || agents[a].busy >= agents[a].slots) {
+            continue;
+        }
+        if (best == -1 || agents[a].slots - agents[a].busy > agents[best].slots - agents[best].busy) {
+            best = a;
+        }
+    }
+    return best;
+}
+
+// Function to give a picked job a slot on its node for this round, launching it on the least loaded
+// node the first time; kept jobs are still running there from the last round and are not signalled.
+// Returns -1 if no node has room for it. Call with the queue lock held.
+static int place_job(int i, int kept) {
+    struct Process *process = &scheduler_queue->processes[i];
+    int a = process->node;
+
+    if (a == -1) {
+        a = least_loaded_agent();
+        if (a == -1) {
+            return -1;
+        }
+        if (send_message(agents[a].fd, MSG_LAUNCH, (uint32_t)process->pid, 0, 0, process->command) == -1) {
+            return -1; // The agent is going away; its poll will show it
+        }
+        process->node = a;
+    } else if (agents[a].busy >= agents[a].slots) {
+        return -1; // Its node is full this round
+    }
+    agents[a].busy++;
+    gettimeofday(&process->start_time, NULL);
+    if (kept) {
+        scheduler_queue->kept_running++;
+    } else {
+        send_message(agents[a].fd, MSG_CONTINUE, (uint32_t)process->pid, 0, 0, NULL);
+    }
+    set_process_state(i, 0);
+    return 0;
+}
+
+// Scheduler loop for coordinator mode: the queue and policy stay here, and every round the picked
+// jobs are continued on the node agents that registered slots. A job is launched on the least
+// loaded node the first time it is picked and stays on that node afterwards. As in the local
+// engine, the last round's jobs are released before the pick and only those it leaves out are
+// stopped, so jobs without contention keep running on their nodes without a message.
+void run_coordinator(void) {
+    int picked[MAX_PROCESSES];
+
+    // Local resource sampling does not describe remote nodes
+    sched_config.memory_aware = 0;
+    open_listener();
+
+    while (1) {
+        char released[MAX_PROCESSES] = { 0 };
+
+        lock_scheduler_queue();
+        int slots = 0;
+        for (int a = 0; a < MAX_AGENTS; a++) {
+            if (agents[a].fd != -1) {
+                agents[a].busy = 0;
+                slots += agents[a].slots;
+            }
+        }
+        policy_on_tick(monotonic_ms());
+        for_each_in_mask(i, scheduler_queue->running_mask) {
+            released[i] = 1;
+            set_process_state(i, 1);
+        }
+        int count = slots > 0 ? policy_pick_next(slots, picked) : 0;
+
+        // Jobs picked again hold their node slots before new ones are placed
+        for (int n = 0; n < count; n++) {
+            if (released[picked[n]]) {
+                released[picked[n]] = place_job(picked[n], 1) == -1;
+            }
+        }
+        for (int n = 0; n < count; n++) {
+            if (scheduler_queue->processes[picked[n]].state == 1 && !released[picked[n]]) {
+                place_job(picked[n], 0);
+            }
+        }
+
+        // Stop the jobs leaving the running set; agents report their CPU time back
+        for (int i = 0; i <= scheduler_queue->rear; i++) {
+            struct Process *process = &scheduler_queue->processes[i];
+            if (!released[i]) {
+                continue;
+            }
+            send_message(agents[process->node].fd, MSG_STOP, (uint32_t)process->pid, 0, 0, NULL);
+            gettimeofday(&process->end_time, NULL);
+            process->waiting_time += (scheduler_queue->rear - 1) * TSLICE;
+            scheduler_queue->preemptions++;
+        }
+        unlock_scheduler_queue();
+
+        serve_agents(monotonic_ms() + TSLICE);
+    }
+}
@@ -0,0 +1,315 @@
+#include "../include/scheduler.h"
+#include "../include/globals.h"
+#include <linux/perf_event.h>
+#include <sched.h>
+#include <sys/syscall.h>
+
+#define MISS_WINDOW_INSTRUCTIONS 1000000 // Instructions a sample must span before its miss rate counts
+#define MAX_LLC_DOMAINS 64
+
+// Structure for the event behind each counter kind
+struct CounterEvent {
+    uint32_t type;
+    uint64_t config;
+};
+
+static const struct CounterEvent counter_events[COUNTER_KINDS] = {
+    [COUNTER_CYCLES] = { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+    [COUNTER_INSTRUCTIONS] = { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+    [COUNTER_LLC_MISSES] = { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+    [COUNTER_CONTEXT_SWITCHES] = { PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES },
+    [COUNTER_PAGE_FAULTS] = { PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS },
+};
+
+// Structure for the counters open on one job; they live in the scheduler process
+struct JobCounters {
+    pid_t pid;                  // 0 for a free entry
+    int fd[COUNTER_KINDS];      // -1 where the event could not be opened
+    long long window_instructions; // Totals when the current miss rate window began
+    long long window_misses;
+};
+
+static struct JobCounters job_counters[MAX_PROCESSES];
+
+// Cache-heavy jobs for the round being picked
+static int heavy_limit;         // Cache-heavy jobs a round may run, one per LLC domain
+static int heavy_charged;
+static int heavy_held;          // A cache-heavy job was held back this round
+
+// Function to open one counter on a job's process tree. Children forked after this are counted too.
+// Software events include kernel context; where that is not allowed they fall back to user context.
+static int open_counter(pid_t pid, int kind) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = counter_events[kind].type;
+    attr.config = counter_events[kind].config;
+    attr.inherit = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    attr.exclude_kernel = attr.type == PERF_TYPE_HARDWARE;
+    attr.exclude_hv = 1;
+
+    int fd = (int)syscall(SYS_perf_event_open, &attr, pid, -1, -1, PERF_FLAG_FD_CLOEXEC);
+    if (fd == -1 && !attr.exclude_kernel && (errno == EACCES || errno == EPERM)) {
+        attr.exclude_kernel = 1;
+        fd = (int)syscall(SYS_perf_event_open, &attr, pid, -1, -1, PERF_FLAG_FD_CLOEXEC);
+    }
+    return fd;
+}
+
+// Function to read a counter, scaled up for any time the kernel multiplexed it off the PMU
+static long long read_counter(int fd) {
+    uint64_t value[3]; // Count, time enabled, time running
+
+    if (fd == -1 || read(fd, value, sizeof(value)) != (ssize_t)sizeof(value)) {
+        return 0;
+    }
+    if (value[2] != 0 && value[2] < value[1]) {
+        return (long long)((double)value[0] * value[1] / value[2]);
+    }
+    return (long long)value[0];
+}
+
+// Function to settle what the host supports on the first job: hardware events, software events only,
+// or nothing; the choice is printed once
+static void probe_counters(pid_t pid) {
+    int fd = open_counter(pid, COUNTER_CONTEXT_SWITCHES);
+    if (fd == -1) {
+        printf("Performance counters unavailable: perf_event_open: %s\n", strerror(errno));
+        fflush(stdout);
+        scheduler_queue->counter_mode = COUNTERS_UNAVAILABLE;
+        return;
+    }
+    close(fd);
+    fd = open_counter(pid, COUNTER_CYCLES);
+    if (fd == -1) {
+        printf("Performance counters: no hardware PMU (%s); using software counters%s\n", strerror(errno),
+               sched_config.interference_mpki > 0 ? ", without interference-aware placement" : "");
+        fflush(stdout);
+        scheduler_queue->counter_mode = COUNTERS_SOFTWARE;
+        return;
+    }
+    close(fd);
+    scheduler_queue->counter_mode = COUNTERS_HARDWARE;
+}
+
+// Function to find the counters open on a job, or NULL
+static struct JobCounters *find_counters(pid_t pid) {
+    for (int j = 0; j < MAX_PROCESSES; j++) {
+        if (job_counters[j].pid == pid) {
+            return &job_counters[j];
+        }
+    }
+    return NULL;
+}
+
+// Function to open counters on a job before it first runs, while it is still stopped ahead of exec;
+// call from the scheduler with the queue lock held. Jobs that already have counters are left alone.
+void open_job_counters(const struct Process *process) {
+    if (!sched_config.counters || scheduler_queue->counter_mode == COUNTERS_UNAVAILABLE ||
+        find_counters(process->pid) != NULL) {
+        return;
+    }
+    if (scheduler_queue->counter_mode == COUNTERS_UNTRIED) {
+        probe_counters(process->pid);
+        if (scheduler_queue->counter_mode == COUNTERS_UNAVAILABLE) {
+            return;
+        }
+    }
+    struct JobCounters *job = find_counters(0);
+    if (job == NULL) {
+        return;
+    }
+
+    job->pid = process->pid;
+    job->window_instructions = 0;
+    job->window_misses = 0;
+    for (int k = 0; k < COUNTER_KINDS; k++) {
+        int hardware = counter_events[k].type == PERF_TYPE_HARDWARE;
+        job->fd[k] = hardware && scheduler_queue->counter_mode != COUNTERS_HARDWARE ? -1 : open_counter(process->pid, k);
+    }
+}
+
+// Function to read the counters open on a job; call from the scheduler without the queue lock, as it
+// takes a read() per counter. Returns -1 if the job has no counters.
+int read_job_counters(pid_t pid, long long values[COUNTER_KINDS]) {
+    struct JobCounters *job = sched_config.counters ? find_counters(pid) : NULL;
+    if (job == NULL) {
+        return -1;
+    }
+    for (int k = 0; k < COUNTER_KINDS; k++) {
+        values[k] = read_counter(job->fd[k]);
+    }
+    return 0;
+}
+
+// Function to store counters read by read_job_counters() in the record of the job at queue position i,
+// and update its recent LLC miss rate once enough instructions have retired; call with the queue lock held
+void apply_job_counters(int i, const long long values[COUNTER_KINDS]) {
+    struct Process *process = &scheduler_queue->processes[i];
+    struct JobCounters *job = find_counters(process->pid);
+    if (job == NULL) {
+        return;
+    }
+
+    for (int k = 0; k < COUNTER_KINDS; k++) {
+        long long value = values[k];
+        if (value > process->counters[k]) {
+            process->counters[k] = value;
+        }
+    }
+    long long instructions = process->counters[COUNTER_INSTRUCTIONS] - job->window_instructions;
+    if (instructions >= MISS_WINDOW_INSTRUCTIONS) {
+        double rate = 1000.0 * (process->counters[COUNTER_LLC_MISSES] - job->window_misses) / instructions;
+        process->miss_rate = process->miss_rate == 0 ? rate : (process->miss_rate + rate) / 2;
+        job->window_instructions = process->counters[COUNTER_INSTRUCTIONS];
+        job->window_misses = process->counters[COUNTER_LLC_MISSES];
+    }
+}
+
+// Function to count the last-level cache domains among the CPUs the scheduler may use
+static int count_llc_domains(void) {
+    static char domains[MAX_LLC_DOMAINS][64];
+    int count = 0;
+    cpu_set_t mask;
+
+    if (sched_getaffinity(0, sizeof(mask), &mask) == -1) {
+        return 1;
+    }
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+        if (!CPU_ISSET(cpu, &mask)) {
+            continue;
+        }
+        for (int index = 0; index < 8; index++) {
+            char path[128], shared[64];
+            int level = 0;
+            snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/cache/index%d/level", cpu, index);
+            FILE *file = fopen(path, "r");
+            if (file == NULL) {
+                break;
+            }
+            if (fscanf(file, "%d", &level) != 1) {
+                level = 0;
+            }
+            fclose(file);
+            if (level != 3) {
+                continue;
+            }
+            snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/cache/index%d/shared_cpu_list", cpu, index);
+            if ((file = fopen(path, "r")) == NULL) {
+                break;
+            }
+            if (fscanf(file, "%63s", shared) == 1) {
+                int known = 0;
+                for (int d = 0; d < count && !known; d++) {
+                    known = strcmp(domains[d], shared) == 0;
+                }
+                if (!known && count < MAX_LLC_DOMAINS) {
+                    strcpy(domains[count++], shared);
+                }
+            }
+            fclose(file);
+            break;
+        }
+    }
+    return count > 0 ? count : 1;
+}
+
+// Function to check whether a job's recent LLC miss rate makes it cache-heavy
+static int cache_heavy(const struct Process *process) {
+    return sched_config.interference_mpki > 0 && process->miss_rate >= sched_config.interference_mpki;
+}
+
+// Function to start a round's interference accounting; call with the queue lock held, after the jobs
+// leaving their slots have been released. Counters of jobs that have left the queue are closed, and the
+// cache-heavy jobs still holding slots are charged to the round, by the miss rates the last
+// attach_job_samples() brought in.
+void begin_interference_round(void) {
+    if (!sched_config.counters) {
+        return;
+    }
+    for (int j = 0; j < MAX_PROCESSES; j++) {
+        if (job_counters[j].pid != 0 && find_process(job_counters[j].pid) == -1) {
+            for (int k = 0; k < COUNTER_KINDS; k++) {
+                if (job_counters[j].fd[k] != -1) {
+                    close(job_counters[j].fd[k]);
+                }
+            }
+            job_counters[j].pid = 0;
+        }
+    }
+
+    if (heavy_held) {
+        scheduler_queue->interference_rounds++;
+    }
+    heavy_held = 0;
+    heavy_charged = 0;
+    if (heavy_limit == 0) {
+        heavy_limit = count_llc_domains();
+    }
+    for_each_in_mask(i, scheduler_queue->running_mask) {
+        interference_charge(&scheduler_queue->processes[i]);
+    }
+}
+
+// Function to check whether a job may run beside the cache-heavy jobs already in this round. This only
+// caps how many run at once, at the number of LLC domains; jobs are not pinned, so the kernel may still
+// place two of them on one domain, and on a host with a single LLC cache-heavy jobs run one at a time.
+int interference_fits(const struct Process *process) {
+    if (!cache_heavy(process) || heavy_charged < heavy_limit) {
+        return 1;
+    }
+    heavy_held = 1;
+    return 0;
+}
+
+// Function to charge a picked job to this round's cache-heavy count
+void interference_charge(const struct Process *process) {
+    if (cache_heavy(process)) {
+        heavy_charged++;
+    }
+}
+
+// Function to append a terminated job's counters to its accounting line: IPC and LLC misses per 1000
+// instructions with a PMU, context switches and page faults without one
+void print_job_counters(const struct Process *process) {
+    const long long *counters = process->counters;
+
+    if (process->in_process) {
+        return;
+    }
+    if (scheduler_queue->counter_mode == COUNTERS_HARDWARE && counters[COUNTER_CYCLES] > 0 &&
+        counters[COUNTER_INSTRUCTIONS] > 0) {
+        printf(", IPC %.2f, %.2f LLC misses/kilo-instruction",
+               (double)counters[COUNTER_INSTRUCTIONS] / counters[COUNTER_CYCLES],
+               1000.0 * counters[COUNTER_LLC_MISSES] / counters[COUNTER_INSTRUCTIONS]);
+    } else if (scheduler_queue->counter_mode == COUNTERS_SOFTWARE) {
+        printf(", %lld context switches, %lld page faults",
+               counters[COUNTER_CONTEXT_SWITCHES], counters[COUNTER_PAGE_FAULTS]);
+    }
+}
+
+// Function to print the counters summed over every terminated job, and what interference-aware
+// placement held back
+void print_counter_summary(void) {
+    const long long *totals = scheduler_queue->counter_totals;
+
+    if (!sched_config.counters || scheduler_queue->counter_mode == COUNTERS_UNTRIED ||
+        scheduler_queue->counter_mode == COUNTERS_UNAVAILABLE) {
+        return;
+    }
+    if (scheduler_queue->counter_mode == COUNTERS_HARDWARE) {
+        printf("Performance counters: %lld instructions, IPC %.2f, %.2f LLC misses/kilo-instruction, ",
+               totals[COUNTER_INSTRUCTIONS],
+               totals[COUNTER_CYCLES] > 0 ? (double)totals[COUNTER_INSTRUCTIONS] / totals[COUNTER_CYCLES] : 0.0,
+               totals[COUNTER_INSTRUCTIONS] > 0 ? 1000.0 * totals[COUNTER_LLC_MISSES] / totals[COUNTER_INSTRUCTIONS] : 0.0);
+    } else {
+        printf("Performance counters (software only): ");
+    }
+    printf("%lld context switches, %lld page faults\n", totals[COUNTER_CONTEXT_SWITCHES], totals[COUNTER_PAGE_FAULTS]);
+    if (sched_config.interference_mpki > 0 && scheduler_queue->counter_mode == COUNTERS_HARDWARE) {
+        printf("Interference-aware placement: at most %d cache-heavy job(s) (>= %d misses/kilo-instruction) at once, "
+               "%lld round(s) and %lld dispatch(es) held back\n", heavy_limit, sched_config.interference_mpki,
+               scheduler_queue->interference_rounds, scheduler_queue->interference_holds);
+    }
+}
@@ -0,0 +1,421 @@
+#include "../include/scheduler.h"
+#include "../include/globals.h"
+#include "../include/daemon.h"
+#include <ctype.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdarg.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#define MAX_CLIENTS 64
+#define CLIENT_OUTPUT 65536
+
+// Structure for a connected client
+struct Client {
+    int fd;                     // -1 for a free entry
+    struct LineReader in;
+    char out[CLIENT_OUTPUT];    // Replies not yet sent
+    size_t out_len;
+    int closing;                // Close once the replies are sent
+};
+
+static struct Client clients[MAX_CLIENTS];
+
+// Submissions collected from every client, answered after one queue_jobs call
+static struct JobSpec pending[MAX_PROCESSES];
+static int pending_client[MAX_PROCESSES];
+static int pending_count = 0;
+
+static volatile sig_atomic_t stop_requested = 0;
+
+// Signal handler for SIGTERM and SIGINT: stop accepting requests and let the queue drain
+static void handle_stop(int signo) {
+    (void)signo;
+    stop_requested = 1;
+}
+
+// Function to queue a reply line for a client
+static void reply(struct Client *client, const char *format, ...) {
+    va_list args;
+    size_t room = CLIENT_OUTPUT - client->out_len;
+
+    va_start(args, format);
+    int n = vsnprintf(client->out + client->out_len, room, format, args);
+    va_end(args);
+    if (n < 0 || (size_t)n + 1 >= room) {
+        client->closing = 1; // Not reading its replies; give up on it
+        return;
+    }
+    client->out_len += n;
+    client->out[client->out_len++] = '\n';
+}
+
+// Function to hand the collected submissions to the scheduler and answer them
+static void flush_submissions(pid_t scheduler_pid) {
+    static pid_t ids[MAX_PROCESSES];
+    int done = 0;
+
+    while (done < pending_count) {
+        int queued = queue_jobs(&pending[done], pending_count - done, scheduler_pid, ids);
+        if (queued == 0) {
+            break;
+        }
+        for (int k = 0; k < queued; k++) {
+            struct Client *client = &clients[pending_client[done + k]];
+            if (ids[k] != 0) {
+                reply(client, "ok %d", (int)ids[k]);
+            } else {
+                reply(client, "error job could not be started");
+            }
+        }
+        done += queued;
+    }
+    for (; done < pending_count; done++) {
+        reply(&clients[pending_client[done]], "error scheduler queue is full");
+    }
+    pending_count = 0;
+}
+
+// Function to answer "status [pid]" from the status snapshot, so a client polling status never
+// waits on the queue lock or holds it up
+static void report_status(struct Client *client, const char *args) {
+    static struct SchedulerSnapshot snapshot;
+    int pid = 0;
+    int count = 0;
+
+    if (*args != '\0' && sscanf(args, "%d", &pid) != 1) {
+        reply(client, "error usage: status [pid]");
+        return;
+    }
+    if (read_snapshot(status_snapshot, &snapshot) == -1) {
+        reply(client, "error status unavailable");
+        return;
+    }
+
+    for (int i = 0; i < snapshot.job_count; i++) {
+        struct JobSnapshot *job = &snapshot.jobs[i];
+        if (pid == 0 || job->pid == pid) {
+            char counters[48];
+            format_job_counters(job, counters, sizeof(counters));
+            reply(client, "job %d %s %d %s %lld %s %s", (int)job->pid, snapshot_state_name(job), job->priority,
+                  job->tenant, job->cpu_ms, counters, job->command);
+            count++;
+        }
+    }
+
+    // A finished job is still known while it is in the terminated ring
+    if (pid != 0 && count == 0) {
+        int first = terminated_queue->rear - MAX_PROCESSES + 1;
+        for (int i = terminated_queue->rear; i >= 0 && i >= first; i--) {
+            struct Process *process = &terminated_queue->processes[i % MAX_PROCESSES];
+            if (process->pid == pid) {
+                struct JobSnapshot job = { .ipc = -1, .mpki = -1 };
+                const long long *totals = process->counters;
+                if (totals[COUNTER_CYCLES] > 0 && totals[COUNTER_INSTRUCTIONS] > 0) {
+                    job.ipc = (double)totals[COUNTER_INSTRUCTIONS] / totals[COUNTER_CYCLES];
+                    job.mpki = 1000.0 * totals[COUNTER_LLC_MISSES] / totals[COUNTER_INSTRUCTIONS];
+                }
+                char counters[48];
+                format_job_counters(&job, counters, sizeof(counters));
+                reply(client, "job %d finished %d - %lld %s %s", (int)process->pid, process->priority,
+                      process->total_execution_time, counters, process->command);
+                count++;
+                break;
+            }
+        }
+        if (count == 0) {
+            reply(client, "error no job with pid %d", pid);
+            return;
+        }
+    }
+    reply(client, "ok %d", count);
+}
+
+// Function to answer "cancel <pid>"
+static void cancel_job(struct Client *client, const char *args) {
+    int pid;
+    int found = 0;
+
+    if (sscanf(args, "%d", &pid) != 1 || pid <= 0) {
+        reply(client, "error usage: cancel <pid>");
+        return;
+    }
+    if (sched_config.listen[0] != '\0') {
+        reply(client, "error cancel is not supported in coordinator mode");
+        return;
+    }
+
+    lock_scheduler_queue();
+    if (find_process(pid) != -1) {
+        killpg(pid, SIGKILL); // Works on stopped processes too; the reaper retires it
+        found = 1;
+    }
+    unlock_scheduler_queue();
+
+    if (found) {
+        reply(client, "ok");
+    } else {
+        reply(client, "error no queued job with pid %d", pid);
+    }
+}
+
+// Function to answer "slots [N|auto]"
+static void change_slots(struct Client *client, const char *args) {
+    if (sched_config.listen[0] != '\0') {
+        reply(client, "error slots are registered by node agents in coordinator mode");
+        return;
+    }
+    int slots = slot_request(args);
+    if (slots == -1) {
+        reply(client, "error usage: slots [N|auto] (N between 1 and %d)", MAX_PROCESSES);
+    } else {
+        reply(client, "ok %d", slots);
+    }
+}
+
+// Function to handle one request line from a client
+static void handle_request(int c, char *line, pid_t scheduler_pid, int legacy_priority) {
+    struct Client *client = &clients[c];
+    char *args;
+
+    while (isspace((unsigned char)*line)) {
+        line++;
+    }
+    if (*line == '\0') {
+        return;
+    }
+    args = line;
+    while (*args != '\0' && !isspace((unsigned char)*args)) {
+        args++;
+    }
+    if (*args != '\0') {
+        *args++ = '\0';
+        while (isspace((unsigned char)*args)) {
+            args++;
+        }
+    }
+
+    if (strcmp(line, "submit") == 0) {
+        if (pending_count == MAX_PROCESSES) {
+            flush_submissions(scheduler_pid);
+        }
+        char error[MAX_SPEC_ERROR];
+        if (parse_job_spec(args, &pending[pending_count], legacy_priority, error) == -1) {
+            reply(client, "error invalid job spec: %s", error);
+            return;
+        }
+        pending_client[pending_count++] = c;
+        return;
+    }
+
+    // Anything else must see the effect of earlier submissions
+    flush_submissions(scheduler_pid);
+    if (strcmp(line, "status") == 0) {
+        report_status(client, args);
+    } else if (strcmp(line, "cancel") == 0) {
+        cancel_job(client, args);
+    } else if (strcmp(line, "slots") == 0) {
+        change_slots(client, args);
+    } else if (strcmp(line, "shutdown") == 0) {
+        stop_requested = 1;
+        reply(client, "ok");
+    } else {
+        reply(client, "error unknown request: %s", line);
+    }
+}
+
+// Function to open the daemon's listening socket, refusing to replace a live daemon's socket
+static int open_socket(const char *path) {
+    struct sockaddr_un addr;
+
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "Socket path too long: %s\n", path);
+        return -1;
+    }
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd == -1) {
+        perror("socket");
+        return -1;
+    }
+    if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) == 0) {
+        fprintf(stderr, "A scheduler daemon is already listening on %s\n", path);
+        close(fd);
+        return -1;
+    }
+    unlink(path); // Stale socket from a daemon that did not exit cleanly
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) == -1 || listen(fd, SOMAXCONN) == -1) {
+        perror(path);
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// Function to send as much pending output as a client will take without blocking
+static void send_output(struct Client *client) {
+    size_t sent = 0;
+    while (sent < client->out_len) {
+        ssize_t n = send(client->fd, client->out + sent, client->out_len - sent, MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (n == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                client->out_len = 0; // Client went away
+                client->closing = 1;
+                return;
+            }
+            break;
+        }
+        sent += n;
+    }
+    memmove(client->out, client->out + sent, client->out_len - sent);
+    client->out_len -= sent;
+}
+
+// Daemon front-end: serve submit/status/cancel requests from any number of clients on a Unix socket
+void run_daemon(pid_t scheduler_pid, int legacy_priority) {
+    int listen_fd = open_socket(sched_config.socket);
+    int printed = 0;
+
+    if (listen_fd == -1) {
+        return;
+    }
+    for (int c = 0; c < MAX_CLIENTS; c++) {
+        clients[c].fd = -1;
+    }
+    printf("Scheduler daemon listening on %s\n", sched_config.socket);
+    fflush(stdout);
+
+    // Signals are only delivered inside ppoll, so the queue is always re-checked after a wake-up
+    signal(SIGTERM, handle_stop);
+    signal(SIGINT, handle_stop);
+    sigset_t block, wait_mask;
+    sigemptyset(&block);
+    sigaddset(&block, SIGCHLD);
+    sigaddset(&block, SIGTERM);
+    sigaddset(&block, SIGINT);
+    sigprocmask(SIG_BLOCK, &block, &wait_mask);
+    sigdelset(&wait_mask, SIGCHLD);
+    sigdelset(&wait_mask, SIGTERM);
+    sigdelset(&wait_mask, SIGINT);
+    terminated_queue->draining = 1; // Task workers keep to what this loop has printed
+
+    while (!stop_requested) {
+        struct pollfd pfds[MAX_CLIENTS + 1];
+        int index[MAX_CLIENTS + 1];
+        int n = 0;
+
+        pfds[n].fd = listen_fd;
+        pfds[n].events = POLLIN;
+        index[n++] = -1;
+        for (int c = 0; c < MAX_CLIENTS; c++) {
+            if (clients[c].fd == -1) {
+                continue;
+            }
+            pfds[n].fd = clients[c].fd;
+            pfds[n].events = 0;
+            if (!clients[c].in.eof && clients[c].out_len <= CLIENT_OUTPUT / 2) {
+                pfds[n].events |= POLLIN; // Stop reading from clients that do not read their replies
+            }
+            if (clients[c].out_len > 0) {
+                pfds[n].events |= POLLOUT;
+            }
+            index[n++] = c;
+        }
+
+        if (ppoll(pfds, n, NULL, &wait_mask) == -1) {
+            if (errno != EINTR) {
+                perror("ppoll");
+                break;
+            }
+            n = 0; // Only a signal: skip straight to reporting
+        }
+
+        for (int k = 0; k < n; k++) {
+            if (pfds[k].revents == 0) {
+                continue;
+            }
+            if (index[k] == -1) {
+                int fd;
+                while ((fd = accept4(listen_fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC)) != -1) {
+                    int c = 0;
+                    while (c < MAX_CLIENTS && clients[c].fd != -1) {
+                        c++;
+                    }
+                    if (c == MAX_CLIENTS) {
+                        close(fd);
+                        break;
+                    }
+                    clients[c].fd = fd;
+                    clients[c].out_len = 0;
+                    clients[c].closing = 0;
+                    line_reader_init(&clients[c].in, fd);
+                }
+                continue;
+            }
+            struct Client *client = &clients[index[k]];
+            if ((pfds[k].revents & (POLLIN | POLLHUP | POLLERR)) && !client->in.eof) {
+                if (line_reader_fill(&client->in) == -1 && errno != EAGAIN && errno != EINTR && errno != ENOBUFS) {
+                    client->closing = 1;
+                }
+            }
+        }
+
+        // Requests are taken from every client in turn; submissions are batched across clients
+        char line[MAX_LINE];
+        for (int c = 0; c < MAX_CLIENTS; c++) {
+            while (clients[c].fd != -1 && !clients[c].closing && clients[c].out_len <= CLIENT_OUTPUT / 2 &&
+                   line_reader_next(&clients[c].in, line, sizeof(line)) == 1) {
+                handle_request(c, line, scheduler_pid, legacy_priority);
+            }
+        }
+        flush_submissions(scheduler_pid);
+
+        for (int c = 0; c < MAX_CLIENTS; c++) {
+            if (clients[c].fd == -1) {
+                continue;
+            }
+            send_output(&clients[c]);
+            int drained = clients[c].in.eof && clients[c].in.start == clients[c].in.len;
+            if ((clients[c].closing || drained) && clients[c].out_len == 0) {
+                close(clients[c].fd);
+                clients[c].fd = -1;
+            }
+        }
+
+        drain_terminated_queue(&printed);
+        fflush(stdout);
+    }
+
+    // Answer what is already buffered, then stop listening and let the queue drain
+    for (int c = 0; c < MAX_CLIENTS; c++) {
+        if (clients[c].fd != -1) {
+            send_output(&clients[c]);
+            close(clients[c].fd);
+        }
+    }
+    close(listen_fd);
+    unlink(sched_config.socket);
+    printf("Scheduler daemon stopping; waiting for %d queued process(es) and %d task(s)\n",
+           scheduler_queue->rear + 1, tasks_outstanding());
+    while (scheduler_queue->rear >= 0 || tasks_outstanding() > 0) {
+        sigsuspend(&wait_mask);
+        drain_terminated_queue(&printed);
+        fflush(stdout);
+    }
+    drain_terminated_queue(&printed); // The last task records may land after the last wake-up's drain
+    sigprocmask(SIG_UNBLOCK, &block, NULL);
+    printf("%d process(es) terminated\n", terminated_queue->rear + 1);
+    print_tenant_usage();
+    print_deadline_summary();
+    print_memory_summary();
+    print_dispatch_summary();
+    print_counter_summary();
+    print_task_summary();
+}
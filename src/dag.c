@@ -0,0 +1,141 @@
+#include "../include/scheduler.h"
+#include "../include/globals.h"
+#include "../include/policy.h"
+
+// Longest estimated run time of a chain of dependents hanging off each queued process, in ms
+static long long downstream[MAX_PROCESSES];
+
+// Function to check whether a wait status means the job succeeded
+static int exited_successfully(int status) {
+    return status != -1 && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+// Function to keep how a finished job ended for later --after lookups; call with the queue lock held
+void record_outcome(const struct Process *process) {
+    long long slot = terminated_queue->outcome_count++ % MAX_JOB_OUTCOMES;
+    struct JobOutcome *outcome = &terminated_queue->outcomes[slot];
+    outcome->seq = process->seq;
+    outcome->pid = process->pid;
+    outcome->exit_status = process->exit_status;
+}
+
+// Function to check a new process's dependencies, given by pid (or task id), against the queue and the
+// outcomes of finished jobs; call with the queue lock held. A pid means the most recent job submitted
+// under it. Queued parents are kept in process->after by submission number, and parents that already
+// succeeded are dropped. Returns -1 (with a message) if a parent failed or is unknown, in which case
+// the process must not be queued.
+int resolve_dependencies(struct Process *process, const pid_t after[], int after_count) {
+    int kept = 0;
+
+    for (int d = 0; d < after_count; d++) {
+        pid_t parent = after[d];
+        int queued = find_process(parent);
+        if (queued != -1) {
+            process->after[kept++] = scheduler_queue->processes[queued].seq;
+            continue;
+        }
+
+        // Not queued: look for its outcome, newest first
+        long long first = terminated_queue->outcome_count - MAX_JOB_OUTCOMES;
+        int found = 0;
+        for (long long t = terminated_queue->outcome_count - 1; t >= 0 && t >= first; t--) {
+            const struct JobOutcome *outcome = &terminated_queue->outcomes[t % MAX_JOB_OUTCOMES];
+            if (outcome->pid == parent) {
+                found = exited_successfully(outcome->exit_status) ? 1 : -1;
+                break;
+            }
+        }
+        if (found == 0) {
+            printf("Rejected: unknown dependency %d: %s\n", (int)parent, process->command);
+            return -1;
+        }
+        if (found == -1) {
+            printf("Rejected: dependency %d failed: %s\n", (int)parent, process->command);
+            return -1;
+        }
+    }
+    process->after_count = kept;
+    return 0;
+}
+
+// Function to update the jobs waiting on a finished process, given its terminated record; call with the
+// queue lock held. On success the dependency is released; on failure every dependent is cancelled as
+// well. Nothing is printed here, as this runs in the SIGCHLD handler: the cancelled job's record names
+// the failed parent, and front-ends report it when they print the record.
+void release_dependents(const struct Process *parent) {
+    int success = exited_successfully(parent->exit_status);
+
+    for (int i = 0; i <= scheduler_queue->rear; i++) {
+        struct Process *process = &scheduler_queue->processes[i];
+        for (int d = 0; d < process->after_count; d++) {
+            if (process->after[d] != parent->seq) {
+                continue;
+            }
+            process->after[d] = process->after[--process->after_count];
+            if (process->after_count == 0) {
+                scheduler_queue->dependent_jobs--;
+            }
+            if (!success && process->state != -1) {
+                process->failed_parent = parent->pid;
+                set_process_state(i, -1);
+                if (process->node == -1 && sched_config.listen[0] != '\0') {
+                    // Never launched on a node: retire it here, which also cancels its dependents
+                    retire_process(i, 0, -1);
+                    i = -1; // The queue shifted; start over
+                } else if (sched_config.listen[0] == '\0') {
+                    killpg(process->pid, SIGKILL); // Its reaping cancels its own dependents
+                }
+            }
+            break;
+        }
+    }
+}
+
+// Function to compute the downstream critical path of process i, memoised in downstream[]
+static long long critical_path(int i, char done[]) {
+    if (done[i]) {
+        return downstream[i];
+    }
+    long long longest = 0;
+    long long seq = scheduler_queue->processes[i].seq;
+    for (int j = 0; j <= scheduler_queue->rear; j++) {
+        struct Process *child = &scheduler_queue->processes[j];
+        for (int d = 0; d < child->after_count; d++) {
+            if (child->after[d] == seq) {
+                long long path = remaining_estimate(child) + critical_path(j, done);
+                if (path > longest) {
+                    longest = path;
+                }
+                break;
+            }
+        }
+    }
+    done[i] = 1;
+    downstream[i] = longest;
+    return longest;
+}
+
+// Function to refresh every queued process's downstream critical path; call with the queue lock held
+static void update_critical_paths(void) {
+    char done[MAX_PROCESSES] = { 0 };
+    for (int i = 0; i <= scheduler_queue->rear; i++) {
+        critical_path(i, done);
+    }
+}
+
+// Function to rank the waiting processes by their remaining critical path, refreshed first: their own
+// estimated remaining time plus the longest chain of dependents after them. Processes nothing depends on
+// rank 0, so they keep their policy's order among themselves; when no queued process waits on another,
+// the graph is not walked at all. Call with the queue lock held.
+void rank_by_critical_path(long long rank[]) {
+    if (scheduler_queue->dependent_jobs == 0) {
+        for_each_in_mask(i, scheduler_queue->waiting_mask) {
+            rank[i] = 0;
+        }
+        return;
+    }
+    update_critical_paths();
+    for_each_in_mask(i, scheduler_queue->waiting_mask) {
+        rank[i] = downstream[i] > 0 ? remaining_estimate(&scheduler_queue->processes[i]) + downstream[i] : 0;
+    }
+}
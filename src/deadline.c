@@ -0,0 +1,151 @@
+#include "../include/scheduler.h"
+#include "../include/globals.h"
+#include "../include/policy.h"
+
+// Earliest-deadline-first policy: admitted deadline jobs run ahead of fair-share work, nearest deadline
+// first, and admission control keeps the admitted set feasible.
+
+// Function to compute a deadline process's density: remaining budget over time left to its deadline
+static double density(const struct Process *process, long long now) {
+    long long remaining = process->budget - process->total_execution_time;
+    long long left = process->deadline - now;
+
+    if (remaining <= 0) {
+        return 0.0;
+    }
+    if (left <= 0 || remaining >= left) {
+        return 1.0; // Needs a whole CPU from now on
+    }
+    return (double)remaining / (double)left;
+}
+
+// Function to test whether a deadline process fits next to the admitted set; call with the queue lock held.
+// Uses the global EDF density bound over the current slots: sum <= slots - (slots - 1) * max.
+static int deadline_feasible(const struct Process *candidate, long long now) {
+    if (candidate->deadline - now < candidate->budget - candidate->total_execution_time) {
+        return 0; // Cannot finish in time even with a CPU to itself
+    }
+
+    double total = density(candidate, now);
+    double max = total;
+    for (int i = 0; i <= scheduler_queue->rear; i++) {
+        struct Process *process = &scheduler_queue->processes[i];
+        if (process == candidate || process->deadline_state != DEADLINE_ADMITTED) {
+            continue;
+        }
+        double d = density(process, now);
+        total += d;
+        if (d > max) {
+            max = d;
+        }
+    }
+    int cpus = scheduler_queue->slots;
+    return total <= cpus - (cpus - 1) * max + 1e-9;
+}
+
+// Function to run admission control on a new deadline process; returns 0 if it must be rejected
+int edf_enqueue(struct Process *process, long long now) {
+    if (process->deadline == 0) {
+        process->deadline_state = DEADLINE_NONE;
+        return 1;
+    }
+    if (deadline_feasible(process, now)) {
+        process->deadline_state = DEADLINE_ADMITTED;
+        return 1;
+    }
+    if (sched_config.admission == ADMISSION_DEFER) {
+        process->deadline_state = DEADLINE_DEFERRED;
+        return 1;
+    }
+    scheduler_queue->deadline_rejected++;
+    return 0;
+}
+
+// Function to admit deferred processes that now fit, earliest deadline first; call with the queue lock held
+static void admit_deferred_jobs(long long now) {
+    while (1) {
+        struct Process *next = NULL;
+        for (int i = 0; i <= scheduler_queue->rear; i++) {
+            struct Process *process = &scheduler_queue->processes[i];
+            if (process->deadline_state == DEADLINE_DEFERRED &&
+                (next == NULL || process->deadline < next->deadline)) {
+                next = process;
+            }
+        }
+        if (next == NULL) {
+            return;
+        }
+
+        if (next->deadline - now < next->budget) {
+            next->deadline_state = DEADLINE_DEMOTED; // Too late to make it; run as ordinary work
+        } else if (deadline_feasible(next, now)) {
+            next->deadline_state = DEADLINE_ADMITTED;
+        } else {
+            return; // Later deadlines are no more likely to fit
+        }
+    }
+}
+
+// Function to pick admitted deadline processes earliest deadline first; call with the queue lock held
+static int pick_deadline_jobs(int slots, int picked[], char taken[]) {
+    int count = 0;
+    while (count < slots) {
+        int best = -1;
+        for_each_in_mask(i, scheduler_queue->waiting_mask) {
+            struct Process *process = &scheduler_queue->processes[i];
+            if (process->after_count > 0 || taken[i] ||
+                process->deadline_state != DEADLINE_ADMITTED || !memory_fits(process) ||
+                !interference_fits(process)) {
+                continue;
+            }
+            if (best == -1 || process->deadline < scheduler_queue->processes[best].deadline) {
+                best = i;
+            }
+        }
+        if (best == -1) {
+            break;
+        }
+        taken[best] = 1;
+        picked[count++] = best;
+        memory_charge(&scheduler_queue->processes[best]);
+        interference_charge(&scheduler_queue->processes[best]);
+    }
+    return count;
+}
+
+// Function to start an EDF round: deferred processes are admitted once the admitted set has room
+void edf_on_tick(long long now) {
+    admit_deferred_jobs(now);
+}
+
+// Function to pick the next round's jobs: admitted deadline processes first, then fair-share work
+int edf_pick_next(int slots, int picked[]) {
+    static long long rank[MAX_PROCESSES];
+    char taken[MAX_PROCESSES] = { 0 };
+
+    int count = pick_deadline_jobs(slots, picked, taken);
+    for_each_in_mask(i, scheduler_queue->waiting_mask) {
+        if (scheduler_queue->processes[i].deadline_state == DEADLINE_ADMITTED) {
+            taken[i] = 1; // Admitted processes that did not fit wait for a deadline slot
+        }
+    }
+    rank_by_critical_path(rank);
+    return fair_share_pick(slots, picked, count, taken, rank, 0);
+}
+
+// Function to let deferred processes into the room a finished process left, so freed slots can go to
+// them before the next round
+void edf_on_exit(const struct Process *process) {
+    if (process->deadline_state == DEADLINE_ADMITTED) {
+        admit_deferred_jobs(monotonic_ms());
+    }
+}
+
+// Function to print how many deadline processes met their deadlines
+void print_deadline_summary(void) {
+    if (scheduler_queue->deadline_jobs == 0 && scheduler_queue->deadline_rejected == 0) {
+        return;
+    }
+    printf("Deadline jobs: %d finished, %d missed, %d rejected by admission control\n",
+           scheduler_queue->deadline_jobs, scheduler_queue->deadline_misses, scheduler_queue->deadline_rejected);
+}
@@ -0,0 +1,306 @@
+#include "../include/scheduler.h"
+#include "../include/globals.h"
+#include "../include/policy.h"
+
+// Latest sample of each queued job's process group, by queue position
+static struct GroupSample samples[MAX_PROCESSES];
+static pid_t sampled_pid[MAX_PROCESSES];
+
+// Jobs to sample next, noted under the queue lock so their groups can be read from /proc, and their
+// performance counters read, outside it; and what was read for them
+static pid_t noted_pids[MAX_PROCESSES];
+static char noted_active[MAX_PROCESSES];
+static struct GroupSample noted_samples[MAX_PROCESSES];
+static char noted_sampled[MAX_PROCESSES];
+static long long noted_counters[MAX_PROCESSES][COUNTER_KINDS];
+static char noted_counted[MAX_PROCESSES];
+static int noted_count;
+
+// Positions released at the end of a slice but still running, until the next pick keeps or stops them
+static char released[MAX_PROCESSES];
+
+// Function used to continue and stop a job's process group. queue_bench swaps in one that signals
+// nothing, so the real dispatch paths can be timed on made-up pids.
+int (*signal_job_group)(pid_t pgrp, int sig) = killpg;
+
+// Function to collect the queue positions holding or parked with a slot (states 0 and 2)
+static void active_positions(uint64_t active[]) {
+    for (int w = 0; w < QUEUE_MASK_WORDS; w++) {
+        active[w] = scheduler_queue->running_mask[w] | scheduler_queue->blocked_mask[w];
+    }
+}
+
+// Function to note the queued jobs, and which hold or are parked with a slot, for the next
+// sample_jobs(); call with the queue lock held, just before releasing it
+void note_jobs_to_sample(void) {
+    noted_count = scheduler_queue->rear + 1;
+    for (int i = 0; i < noted_count; i++) {
+        int state = scheduler_queue->processes[i].state;
+        noted_pids[i] = scheduler_queue->pids[i];
+        noted_active[i] = state == 0 || state == 2;
+        noted_sampled[i] = 0;
+        noted_counted[i] = 0;
+    }
+}
+
+// Function to read the performance counters of the jobs noted as holding or parked with a slot; call
+// WITHOUT the queue lock, like sample_jobs(), which calls it
+void sample_job_counters(void) {
+    for (int n = 0; n < noted_count; n++) {
+        noted_counted[n] = noted_active[n] && read_job_counters(noted_pids[n], noted_counters[n]) == 0;
+    }
+}
+
+// Function to sample the process groups of the jobs noted as holding or parked with a slot, and with
+// with_rss those of every noted job along with their working sets, then their counters; call WITHOUT
+// the queue lock, so submissions, status readers and the reaper are never held up by /proc reads
+void sample_jobs(int with_rss) {
+    pid_t leaders[MAX_PROCESSES];
+    int index[MAX_PROCESSES];
+    struct GroupSample found[MAX_PROCESSES];
+    int count = 0;
+
+    for (int n = 0; n < noted_count; n++) {
+        if (noted_active[n] || with_rss) {
+            leaders[count] = noted_pids[n];
+            index[count++] = n;
+        }
+    }
+    sample_process_groups(leaders, count, found, with_rss);
+    for (int c = 0; c < count; c++) {
+        noted_samples[index[c]] = found[c];
+        noted_sampled[index[c]] = with_rss ? 2 : 1;
+    }
+    sample_job_counters();
+}
+
+// Function to match the latest samples and counter readings to the jobs' current queue positions, which
+// exits may have shifted since they were noted, and keep each job's peak working set; call with the
+// queue lock held
+void attach_job_samples(void) {
+    uint64_t active[QUEUE_MASK_WORDS];
+    int i = 0;
+
+    active_positions(active);
+    for_each_in_mask(j, active) {
+        samples[j].state = '?';
+        samples[j].members = 0;
+        sampled_pid[j] = 0;
+    }
+    for (int n = 0; n < noted_count; n++) {
+        if (!noted_sampled[n] && !noted_counted[n]) {
+            continue;
+        }
+        // Exits only remove jobs, so the queue keeps the noted order
+        int j = i;
+        while (j <= scheduler_queue->rear && scheduler_queue->pids[j] != noted_pids[n]) {
+            j++;
+        }
+        if (j > scheduler_queue->rear) {
+            continue;
+        }
+        struct Process *process = &scheduler_queue->processes[j];
+        if (noted_sampled[n]) {
+            samples[j] = noted_samples[n];
+            sampled_pid[j] = noted_pids[n];
+        }
+        if (noted_sampled[n] == 2 && noted_samples[n].members > 0 && noted_samples[n].rss_kb > process->rss_kb) {
+            process->rss_kb = noted_samples[n].rss_kb;
+        }
+        if (noted_counted[n]) {
+            apply_job_counters(j, noted_counters[n]);
+        }
+        i = j + 1;
+    }
+    noted_count = 0;
+}
+
+// Function to charge the CPU time the process group at queue position i used since it was last
+// charged to the job and its tenant, as of the latest sample
+static void charge_cpu(int i) {
+    struct Process *process = &scheduler_queue->processes[i];
+    long long cpu_ns = samples[i].cpu_ns;
+    if (sampled_pid[i] != process->pid || samples[i].members == 0 || cpu_ns <= process->cpu_ns) {
+        return;
+    }
+    long long delta = cpu_ns / 1000000 - process->cpu_ns / 1000000;
+    process->cpu_ns = cpu_ns;
+    process->total_execution_time += delta;
+    scheduler_queue->tenants[process->tenant].usage += delta;
+}
+
+// Function to continue picked processes; call with the queue lock held. Processes picked again
+// straight after release_running_jobs() never stopped, so they are not signalled.
+void start_jobs(const int picked[], int count) {
+    for (int n = 0; n < count; n++) {
+        struct Process *process = &scheduler_queue->processes[picked[n]];
+
+        if (sem_wait(&print_sem) == -1) {
+            perror("sem_wait (print_sem)");
+        }
+        if (sem_post(&print_sem) == -1) {
+            perror("sem_post (print_sem)");
+        }
+        gettimeofday(&process->start_time, NULL);
+        process->slice_cpu_ns = process->cpu_ns;
+        open_job_counters(process);
+        long long quantum = job_quantum(process);
+        process->quantum_end = quantum != 0 ? monotonic_ms() + quantum : 0;
+        if (released[picked[n]]) {
+            released[picked[n]] = 0;
+            scheduler_queue->kept_running++;
+        } else if (signal_job_group(process->pid, SIGCONT) == -1) {
+            perror("killpg (SIGCONT)");
+        }
+        set_process_state(picked[n], 0);
+    }
+}
+
+// Function to stop the running job at queue position i and account the CPU time its group used
+static void stop_job(int i) {
+    struct Process *process = &scheduler_queue->processes[i];
+
+    if (sem_wait(&print_sem) == -1) {
+        perror("sem_wait (print_sem)");
+    }
+    if (sem_post(&print_sem) == -1) {
+        perror("sem_post (print_sem)");
+    }
+    if (signal_job_group(process->pid, SIGSTOP) == -1) {
+        perror("killpg (SIGSTOP)");
+    }
+    gettimeofday(&process->end_time, NULL);
+    charge_cpu(i);
+    process->waiting_time += (scheduler_queue->rear - 1) * TSLICE;
+    set_process_state(i, 1);
+}
+
+// Function to let the picked processes run for one slice, sampling them every SAMPLE_INTERVAL_MS.
+// A job counts as runnable while any thread in its group is. A job found sleeping or in I/O wait
+// keeps running but gives up its slot, which is refilled from the queue at once. When it becomes
+// runnable again it takes a slot back straight away, stopping the running process that has used
+// the most CPU this slice if none is free.
+void run_slice(int slice_ms, int slots) {
+    long long slice_end = monotonic_ms() + slice_ms;
+    int picked[MAX_PROCESSES];
+
+    while (1) {
+        long long left = slice_end - monotonic_ms();
+        if (left <= 0) {
+            break;
+        }
+        usleep((left < SAMPLE_INTERVAL_MS ? left : SAMPLE_INTERVAL_MS) * 1000);
+
+        sample_jobs(0);
+        lock_scheduler_queue();
+        attach_job_samples();
+        int running = 0;
+        int woken[MAX_PROCESSES];
+        int woken_count = 0;
+        uint64_t active[QUEUE_MASK_WORDS];
+        active_positions(active);
+        for_each_in_mask(i, active) {
+            struct Process *process = &scheduler_queue->processes[i];
+            char task_state = samples[i].state;
+            if (process->state == 0 && task_state == 'T' && progress_yielded(process->progress_slot)) {
+                // Stopped itself at a safe point with progress_yield(): requeue it and refill its slot
+                stop_job(i);
+                scheduler_queue->yields++;
+            } else if (process->state == 0 && (task_state == 'S' || task_state == 'D')) {
+                charge_cpu(i);
+                set_process_state(i, 2);
+                policy_on_block(i);
+                scheduler_queue->blocked_releases++;
+            } else if (process->state == 2 && task_state == 'R') {
+                woken[woken_count++] = i;
+            } else if (process->state == 0) {
+                running++;
+            }
+        }
+
+        // Woken processes are I/O-bound: they get their slot back ahead of the queue
+        for (int n = 0; n < woken_count; n++) {
+            struct Process *process = &scheduler_queue->processes[woken[n]];
+            if (running >= slots) {
+                int victim = -1;
+                for_each_in_mask(i, scheduler_queue->running_mask) {
+                    struct Process *candidate = &scheduler_queue->processes[i];
+                    charge_cpu(i);
+                    if (victim == -1 || candidate->cpu_ns - candidate->slice_cpu_ns >
+                                        scheduler_queue->processes[victim].cpu_ns -
+                                        scheduler_queue->processes[victim].slice_cpu_ns) {
+                        victim = i;
+                    }
+                }
+                if (victim != -1) {
+                    stop_job(victim);
+                    running--;
+                }
+            }
+            charge_cpu(woken[n]);
+            gettimeofday(&process->start_time, NULL);
+            process->slice_cpu_ns = process->cpu_ns;
+            set_process_state(woken[n], 0);
+            running++;
+            scheduler_queue->wake_boosts++;
+        }
+
+        // Hand slots released by blocked processes to waiting ones
+        if (running < slots) {
+            int count = policy_pick_next(slots - running, picked);
+            start_jobs(picked, count);
+        }
+        note_jobs_to_sample();
+        unlock_scheduler_queue();
+    }
+}
+
+// Function to end a slice: the processes holding slots go back to the waiting set but keep running, so
+// the next pick can keep them without a stop and continue; call with the queue lock held, and call
+// stop_released_jobs() after the pick. Blocked processes stay parked, and processes whose sized
+// quantum (see job_quantum) runs past the slice keep their slots. Samples are taken from the last
+// attach_job_samples().
+void release_running_jobs(void) {
+    long long now = monotonic_ms();
+    for_each_in_mask(j, scheduler_queue->running_mask) {
+        struct Process *process = &scheduler_queue->processes[j];
+        if (process->quantum_end > now) {
+            continue;
+        }
+        if (samples[j].state == 'T' && progress_yielded(process->progress_slot)) {
+            stop_job(j); // Yielded at the end of the slice: it must be continued to run again
+            scheduler_queue->yields++;
+            continue;
+        }
+        charge_cpu(j);
+        released[j] = 1;
+        set_process_state(j, 1);
+    }
+}
+
+// Function to stop the released processes the pick left out: only jobs leaving the running set are
+// preempted; call with the queue lock held
+void stop_released_jobs(void) {
+    for (int i = 0; i <= scheduler_queue->rear; i++) {
+        if (released[i]) {
+            released[i] = 0;
+            stop_job(i);
+            scheduler_queue->preemptions++;
+        }
+    }
+}
+
+// Function to print how often blocked processes released their slots
+void print_dispatch_summary(void) {
+    if (scheduler_queue->blocked_releases != 0) {
+        printf("I/O-aware dispatch: %lld slot(s) released by blocked processes, %lld wake-up boost(s)\n",
+               scheduler_queue->blocked_releases, scheduler_queue->wake_boosts);
+    }
+    if (scheduler_queue->kept_running != 0) {
+        printf("Minimal preemption: %lld slice(s) continued without a stop, %lld preemption(s)\n",
+               scheduler_queue->kept_running, scheduler_queue->preemptions);
+    }
+    if (scheduler_queue->yields != 0) {
+        printf("Progress: %lld slot(s) given up by jobs yielding at safe points\n", scheduler_queue->yields);
+    }
+}
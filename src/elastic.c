@@ -0,0 +1,277 @@
+#include "../include/scheduler.h"
+#include "../include/globals.h"
+#include <ctype.h>
+#include <math.h>
+#include <sched.h>
+
+// Host load as of the last elastic sample
+static long long sampled_at;            // Monotonic ms, 0 before the first sample
+static long long cpu_busy[CPU_SETSIZE];  // Per-CPU /proc/stat busy jiffies, for the CPUs we may use
+static long long cpu_total[CPU_SETSIZE];  // ... and all jiffies, 0 where not sampled yet
+static long long own_cpu_ms;            // CPU time charged to our jobs
+static double others_cpus;              // Smoothed CPUs used by everything else on the host
+static int elastic_count;               // Slot count elastic sizing settled on
+static int announced_count;             // ... and the count last printed
+
+// Taken by sample_host_load() outside the queue lock, applied by update_slots() under it
+static struct {
+    int ready;                          // A sample is waiting to be applied
+    long long at;                       // Monotonic ms it was taken
+    int limit;                          // Usable CPUs, bounded by -n if given
+    int mask_cpus;                      // CPUs in our affinity mask
+    int have_busy;                      // busy_cpus holds a measurement over a previous interval
+    double busy_cpus;                   // CPUs of the mask busy since the previous sample
+} host_sample;
+
+// Function to read a cgroup CPU quota file pair and return the CPUs it allows (rounded up), or 0 for
+// no limit. v2 keeps "quota period" in cpu.max; v1 keeps each in its own file.
+static int read_cpu_quota(const char *dir) {
+    char path[PATH_MAX];
+    long long quota = -1, period = 0;
+
+    snprintf(path, sizeof(path), "%s/cpu.max", dir);
+    FILE *file = fopen(path, "r");
+    if (file != NULL) {
+        char text[32];
+        if (fscanf(file, "%31s %lld", text, &period) == 2 && isdigit((unsigned char)text[0])) {
+            quota = atoll(text);
+        }
+        fclose(file);
+    } else {
+        snprintf(path, sizeof(path), "%s/cpu.cfs_quota_us", dir);
+        if ((file = fopen(path, "r")) != NULL) {
+            if (fscanf(file, "%lld", &quota) != 1) {
+                quota = -1;
+            }
+            fclose(file);
+        }
+        snprintf(path, sizeof(path), "%s/cpu.cfs_period_us", dir);
+        if ((file = fopen(path, "r")) != NULL) {
+            if (fscanf(file, "%lld", &period) != 1) {
+                period = 0;
+            }
+            fclose(file);
+        }
+    }
+    if (quota <= 0 || period <= 0) {
+        return 0;
+    }
+    return (int)((quota + period - 1) / period);
+}
+
+// Function to find the tightest CPU quota on this process's cgroup and its ancestors, or 0 for none
+static int cgroup_cpu_limit(void) {
+    FILE *file = fopen("/proc/self/cgroup", "r");
+    if (file == NULL) {
+        return 0;
+    }
+
+    char line[PATH_MAX];
+    int limit = 0;
+    while (fgets(line, sizeof(line), file) != NULL) {
+        // "0::/path" on the unified hierarchy, "N:cpu,cpuacct:/path" on v1
+        char *controllers = strchr(line, ':');
+        char *relative = controllers != NULL ? strchr(controllers + 1, ':') : NULL;
+        if (relative == NULL) {
+            continue;
+        }
+        *relative++ = '\0';
+        relative[strcspn(relative, "\n")] = '\0';
+        controllers++;
+
+        char dir[PATH_MAX];
+        if (*controllers == '\0') {
+            snprintf(dir, sizeof(dir), "/sys/fs/cgroup%s", relative);
+        } else if (strstr(controllers, "cpu") != NULL && strstr(controllers, "cpuset") != controllers) {
+            snprintf(dir, sizeof(dir), "/sys/fs/cgroup/%s%s", controllers, relative);
+        } else {
+            continue;
+        }
+        // A quota anywhere up the hierarchy applies; the mount may hide the levels above it
+        while (1) {
+            int cpus = read_cpu_quota(dir);
+            if (cpus > 0 && (limit == 0 || cpus < limit)) {
+                limit = cpus;
+            }
+            char *slash = strrchr(dir, '/');
+            if (slash == NULL || slash - dir <= (long)strlen("/sys/fs/cgroup")) {
+                break;
+            }
+            *slash = '\0';
+        }
+    }
+    fclose(file);
+    return limit;
+}
+
+// Function to count the CPUs the scheduler may really use: its affinity mask, capped by cgroup CPU quotas
+int usable_cpus(void) {
+    cpu_set_t mask;
+    int cpus = 0;
+
+    if (sched_getaffinity(0, sizeof(mask), &mask) == 0) {
+        cpus = CPU_COUNT(&mask);
+    }
+    if (cpus <= 0) {
+        long online = sysconf(_SC_NPROCESSORS_ONLN);
+        cpus = online > 0 ? (int)online : 1;
+    }
+    int quota = cgroup_cpu_limit();
+    return quota > 0 && quota < cpus ? quota : cpus;
+}
+
+// Function to read the per-CPU lines of /proc/stat and add up how busy the CPUs in mask were since they
+// were last read, in CPUs; returns -1 if /proc/stat cannot be read
+static int read_affinity_busy(const cpu_set_t *mask, double *busy_cpus) {
+    FILE *file = fopen("/proc/stat", "r");
+    if (file == NULL) {
+        return -1;
+    }
+
+    char line[256];
+    *busy_cpus = 0;
+    while (fgets(line, sizeof(line), file) != NULL) {
+        int cpu;
+        long long user, nice, system, idle, iowait, irq, softirq, steal = 0;
+        if (strncmp(line, "cpu", 3) != 0 || !isdigit((unsigned char)line[3])) {
+            continue; // The aggregate line covers CPUs we may not use
+        }
+        if (sscanf(line + 3, "%d %lld %lld %lld %lld %lld %lld %lld %lld", &cpu, &user, &nice, &system,
+                   &idle, &iowait, &irq, &softirq, &steal) < 8 ||
+            cpu < 0 || cpu >= CPU_SETSIZE || !CPU_ISSET(cpu, mask)) {
+            continue;
+        }
+        long long busy = user + nice + system + irq + softirq + steal;
+        long long total = busy + idle + iowait;
+        if (cpu_total[cpu] != 0 && total > cpu_total[cpu]) {
+            *busy_cpus += (double)(busy - cpu_busy[cpu]) / (total - cpu_total[cpu]);
+        }
+        cpu_busy[cpu] = busy;
+        cpu_total[cpu] = total;
+    }
+    fclose(file);
+    return 0;
+}
+
+// Function to sample host load for elastic sizing, at most every ELASTIC_SAMPLE_MS; call from the
+// scheduler without the queue lock, before the round's update_slots(). The cgroup, affinity and
+// /proc/stat reads happen here, and so does announcing a change made by the last update_slots().
+void sample_host_load(void) {
+    if (!sched_config.elastic) {
+        return;
+    }
+    if (announced_count != 0 && elastic_count != announced_count) {
+        printf("Elastic slots: %d -> %d (%d usable CPU(s), %.1f busy with other work)\n",
+               announced_count, elastic_count, host_sample.limit, others_cpus);
+        fflush(stdout);
+    }
+    announced_count = elastic_count;
+
+    long long now = monotonic_ms();
+    if (host_sample.ready || (host_sample.at != 0 && now - host_sample.at < ELASTIC_SAMPLE_MS)) {
+        return;
+    }
+
+    int limit = usable_cpus();
+    if (NCPU > 0 && NCPU < limit) {
+        limit = NCPU;
+    }
+    cpu_set_t mask;
+    int mask_cpus;
+    if (sched_getaffinity(0, sizeof(mask), &mask) == 0) {
+        mask_cpus = CPU_COUNT(&mask);
+    } else {
+        long online = sysconf(_SC_NPROCESSORS_ONLN);
+        mask_cpus = online > 0 ? (int)online : 1;
+        CPU_ZERO(&mask);
+        for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+            CPU_SET(cpu, &mask);
+        }
+    }
+
+    host_sample.have_busy = read_affinity_busy(&mask, &host_sample.busy_cpus) == 0 && host_sample.at != 0;
+    host_sample.at = now;
+    host_sample.limit = limit;
+    host_sample.mask_cpus = mask_cpus;
+    host_sample.ready = 1;
+}
+
+// Function to size the slot count from the last host load sample: the usable CPUs (bounded by -n if
+// given), less the CPUs of our affinity mask that other tenants kept busy, smoothed over the last few
+// samples, and never below one. Load on CPUs outside the mask does not take slots away. Call with the
+// queue lock held; without a new sample the count stays as it was.
+static int elastic_slots(void) {
+    if (!host_sample.ready) {
+        return elastic_count > 0 ? elastic_count : (NCPU > 0 ? NCPU : 1);
+    }
+    host_sample.ready = 0;
+
+    long long own = 0;
+    for (int t = 0; t < scheduler_queue->tenant_count; t++) {
+        own += scheduler_queue->tenants[t].usage;
+    }
+    if (host_sample.have_busy && sampled_at != 0 && host_sample.at > sampled_at) {
+        // Everything busy on our CPUs, less what our own jobs were charged
+        double own_cpus = (double)(own - own_cpu_ms) / (host_sample.at - sampled_at);
+        double others = host_sample.busy_cpus - own_cpus;
+        others_cpus = (others_cpus + (others > 0 ? others : 0)) / 2;
+    }
+    own_cpu_ms = own;
+    sampled_at = host_sample.at;
+
+    // A cgroup quota caps how many we may use at once, but other work only competes for the mask's CPUs
+    int slots = host_sample.mask_cpus - (int)floor(others_cpus + 0.5);
+    if (slots > host_sample.limit) {
+        slots = host_sample.limit;
+    }
+    if (slots < 1) {
+        slots = 1;
+    }
+    elastic_count = slots;
+    return slots;
+}
+
+// Function to decide how many slots the next round has; call from the scheduler with the queue lock held.
+// A count set with the slots command wins; otherwise elastic mode follows the host load sampled by
+// sample_host_load(), or NCPU is used.
+int update_slots(void) {
+    int slots = NCPU;
+    if (scheduler_queue->slot_override > 0) {
+        slots = scheduler_queue->slot_override;
+    } else if (sched_config.elastic) {
+        slots = elastic_slots();
+    }
+    scheduler_queue->slots = slots;
+    return slots;
+}
+
+// Function to handle "slots [N|auto]" from a front-end. N fixes the slot count from the next round on,
+// "auto" hands it back to NCPU or elastic sizing. Returns the count in effect (or requested), or -1 for
+// bad arguments.
+int slot_request(const char *args) {
+    while (isspace((unsigned char)*args)) {
+        args++;
+    }
+    int result;
+    lock_scheduler_queue();
+    if (*args == '\0') {
+        result = scheduler_queue->slots;
+    } else if (strcmp(args, "auto") == 0) {
+        scheduler_queue->slot_override = 0;
+        result = scheduler_queue->slots;
+    } else {
+        char *end;
+        long count = strtol(args, &end, 10);
+        while (isspace((unsigned char)*end)) {
+            end++;
+        }
+        if (*end != '\0' || count < 1 || count > MAX_PROCESSES) {
+            result = -1;
+        } else {
+            scheduler_queue->slot_override = (int)count;
+            result = (int)count;
+        }
+    }
+    unlock_scheduler_queue();
+    return result;
+}
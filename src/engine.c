@@ -0,0 +1,185 @@
+#include "../include/scheduler.h"
+#include "../include/globals.h"
+#include "../include/policy.h"
+
+// Dispatch engine shared by every scheduler build: sets up the shared queue, forks the scheduler process
+// and runs the front-end. What the scheduler does with the queue is decided by the configured policy
+// (policy.h), default_policy if none was chosen. A build that defaults to the priority policy also
+// accepts the original "submit <program> <priority>" form.
+int run_scheduler(SchedPolicy default_policy) {
+    // Initialize semaphores
+    if (sem_init(&scheduler_sem, 0, 0) == -1) {
+        perror("sem_init (scheduler_sem)");
+        exit(1);
+    }
+    if (sem_init(&print_sem, 0, 1) == -1) {
+        perror("sem_init (print_sem)");
+        exit(1);
+    }
+
+    // Set up the SIGCHLD signal handler
+    if (signal(SIGCHLD, handleSIGCHLD) == SIG_ERR) {
+        perror("signal");
+        exit(1);
+    }
+
+    read_scheduler_settings();
+    if (sched_config.policy == POLICY_DEFAULT) {
+        sched_config.policy = default_policy;
+    }
+    int legacy_priority = (default_policy == POLICY_PRIORITY);
+
+    // Register the SIGUSR1 signal handler
+    if (signal(SIGUSR1, (void (*)(int)) handleSIGUSR1) == SIG_ERR) {
+        perror("signal");
+        exit(1);
+    }
+
+    // Create shared memory for the process queue
+    shmid = shmget(IPC_PRIVATE, sizeof(struct ProcessQueue), 0666 | IPC_CREAT);
+    if (shmid < 0) {
+        perror("shmget");
+        exit(1);
+    }
+
+    scheduler_queue = shmat(shmid, NULL, 0);
+    if (scheduler_queue == (void*) -1) {
+        perror("shmat");
+        exit(1);
+    }
+    scheduler_queue->rear = -1;
+    if (sem_init(&scheduler_queue->lock, 1, 1) == -1) {
+        perror("sem_init (scheduler_queue lock)");
+        exit(1);
+    }
+
+    // Create shared memory for the terminated queue
+    int terminated_shmid = shmget(IPC_PRIVATE, sizeof(struct TerminatedQueue), 0666 | IPC_CREAT);
+    if (terminated_shmid < 0) {
+        perror("shmget for terminated queue");
+        exit(1);
+    }
+
+    terminated_queue = shmat(terminated_shmid, NULL, 0);
+    if (terminated_queue == (void*) -1) {
+        perror("shmat for terminated queue");
+        exit(1);
+    }
+    terminated_queue->rear = -1;
+    scheduler_queue->slots = NCPU > 0 ? NCPU : usable_cpus();
+
+    // Predictions start from the runtime model saved by earlier runs
+    if (sched_config.runtime_db[0] != '\0' && load_runtime_model(sched_config.runtime_db) == -1) {
+        exit(1);
+    }
+
+    // Submissions and exits are traced for bin/replay
+    if (sched_config.record[0] != '\0' && open_trace(sched_config.record) == -1) {
+        exit(1);
+    }
+
+    // Jobs linked with progress.h report remaining work into a table they inherit; only the dispatch
+    // loop stops and requeues a job that yields
+    if (create_progress_table(MAX_PROCESSES, !sched_config.passthrough && sched_config.listen[0] == '\0') == -1) {
+        printf("Progress reporting is unavailable\n");
+    }
+
+    // Status readers poll a snapshot of the queue instead of taking its lock
+    status_snapshot = create_snapshot(sched_config.snapshot);
+    if (status_snapshot == NULL) {
+        exit(1);
+    }
+
+    // Fork the scheduler process
+    pid_t scheduler_pid = fork();
+    if (scheduler_pid == -1) {
+        perror("fork");
+        exit(1);
+    }
+    if (scheduler_pid == 0) {
+        // Child process (Scheduler)
+        int picked[MAX_PROCESSES];
+
+        policy_init();
+        if (sched_config.listen[0] != '\0') {
+            run_coordinator();
+        }
+        if (sched_config.passthrough) {
+            run_passthrough_scheduler();
+        }
+        while (1) {
+            // Pick the next running set under the policy from the waiting processes and those that ran
+            // last slice; tenants share the CPUs by weight. Only jobs leaving the set are stopped and
+            // only jobs entering it are continued, so without contention jobs run uninterrupted.
+            sample_jobs(sched_config.memory_aware);
+            sample_host_load();
+            lock_scheduler_queue();
+            attach_job_samples();
+            int slots = begin_memory_round(update_slots());
+            policy_on_tick(monotonic_ms());
+            release_running_jobs();
+            begin_interference_round();
+            // Jobs still inside a sized quantum keep their slots from the last round
+            int free_slots = slots - count_in_mask(scheduler_queue->running_mask);
+            int count = policy_pick_next(free_slots > 0 ? free_slots : 0, picked);
+            start_jobs(picked, count);
+            stop_released_jobs();
+            int slice = policy_slice_ms(picked, count);
+            note_jobs_to_sample();
+            unlock_scheduler_queue();
+
+            // Run for the slice, handing the slots of blocked processes to waiting ones
+            run_slice(slice, slots);
+        }
+    } else {
+        // Parent process (Shell, or the batch reader when headless)
+        if (start_job_logs() == -1) {
+            shutdown_scheduler(scheduler_pid);
+            remove_snapshot(sched_config.snapshot);
+            exit(1);
+        }
+        if (sched_config.daemon) {
+            run_daemon(scheduler_pid, legacy_priority);
+        } else if (sched_config.headless) {
+            run_batch_ingest(scheduler_pid, legacy_priority);
+        } else {
+            run_scheduler_shell(scheduler_pid, legacy_priority);
+        }
+
+        // Wait for submitted processes to complete
+        shutdown_scheduler(scheduler_pid);
+        if (!sched_config.headless && !sched_config.daemon) {
+            printTerminatedQueue(terminated_queue);
+        }
+        stop_task_pool();
+        if (sched_config.runtime_db[0] != '\0') {
+            save_runtime_model(sched_config.runtime_db);
+        }
+        stop_job_logs();
+        remove_snapshot(sched_config.snapshot);
+        exit(0);
+    }
+
+    printTerminatedQueue(terminated_queue);
+    
+    // Clean up shared memory
+    if (sem_destroy(&scheduler_queue->lock) == -1) {
+        perror("sem_destroy (scheduler_queue lock)");
+    }
+    if (shmdt(scheduler_queue) == -1) {
+        perror("shmdt (scheduler_queue)");
+    }
+    if (shmctl(shmid, IPC_RMID, NULL) == -1) {
+        perror("shmctl (scheduler_queue)");
+    }
+
+    // Destroy semaphores
+    if (sem_destroy(&scheduler_sem) == -1) {
+        perror("sem_destroy (scheduler_sem)");
+    }
+    if (sem_destroy(&print_sem) == -1) {
+        perror("sem_destroy (print_sem)");
+    }
+    
+    return 0;
+}
@@ -0,0 +1,186 @@
+#include "../include/scheduler.h"
+#include "../include/globals.h"
+#include "../include/policy.h"
+
+// Function to record a configured weight for a tenant, from "weight.NAME = W" or --weight NAME=W
+int set_tenant_weight(const char *name, const char *value) {
+    char *end;
+    long weight = strtol(value, &end, 10);
+
+    if (*name == '\0' || strlen(name) >= MAX_TENANT_NAME) {
+        fprintf(stderr, "Invalid tenant name: %s\n", name);
+        return -1;
+    }
+    if (*value == '\0' || *end != '\0' || weight < 1 || weight > 1000) {
+        fprintf(stderr, "Invalid weight for %s: %s (must be 1-1000)\n", name, value);
+        return -1;
+    }
+
+    for (int i = 0; i < sched_config.weight_count; i++) {
+        if (strcmp(sched_config.weights[i].name, name) == 0) {
+            sched_config.weights[i].weight = (int)weight;
+            return 0;
+        }
+    }
+    if (sched_config.weight_count == MAX_TENANTS) {
+        fprintf(stderr, "Too many tenant weights (maximum %d)\n", MAX_TENANTS);
+        return -1;
+    }
+    strcpy(sched_config.weights[sched_config.weight_count].name, name);
+    sched_config.weights[sched_config.weight_count].weight = (int)weight;
+    sched_config.weight_count++;
+    return 0;
+}
+
+// Function to find or create a tenant by name; call with the queue lock held
+int intern_tenant(const char *name) {
+    for (int i = 0; i < scheduler_queue->tenant_count; i++) {
+        if (strcmp(scheduler_queue->tenants[i].name, name) == 0) {
+            return i;
+        }
+    }
+    if (scheduler_queue->tenant_count == MAX_TENANTS) {
+        fprintf(stderr, "Too many tenants; charging %s to %s\n", name, scheduler_queue->tenants[0].name);
+        return 0;
+    }
+
+    struct Tenant *tenant = &scheduler_queue->tenants[scheduler_queue->tenant_count];
+    memset(tenant, 0, sizeof(*tenant));
+    strncpy(tenant->name, name, MAX_TENANT_NAME - 1);
+    tenant->weight = 1;
+    for (int i = 0; i < sched_config.weight_count; i++) {
+        if (strcmp(sched_config.weights[i].name, name) == 0) {
+            tenant->weight = sched_config.weights[i].weight;
+        }
+    }
+    return scheduler_queue->tenant_count++;
+}
+
+// Function to check whether a process competes for fair-share slots
+static int fair_share_eligible(const struct Process *process) {
+    return process->state == 1 && process->after_count == 0 && process->deadline_state != DEADLINE_DEFERRED;
+}
+
+// Function to pick the waiting process of a tenant whose working set fits this round: the one with the
+// highest rank, ties going to the one that has waited longest since it last ran; returns -1 if none fits.
+// held[0] and held[1] count the candidates turned away for memory and for the cache-heavy cap.
+static int pick_in_tenant(int tenant, int level, const long long rank[], const char taken[], int held[2]) {
+    int best = -1;
+    held[0] = held[1] = 0;
+    for_each_in_mask(i, scheduler_queue->waiting_mask) {
+        struct Process *process = &scheduler_queue->processes[i];
+        if (!fair_share_eligible(process) || process->tenant != tenant || taken[i]) {
+            continue;
+        }
+        if (level != 0 && process->priority != level) {
+            continue;
+        }
+        if (!memory_fits(process)) {
+            held[0]++;
+            continue;
+        }
+        if (!interference_fits(process)) {
+            held[1]++;
+            continue;
+        }
+        if (best == -1 || rank[i] > rank[best] ||
+            (rank[i] == rank[best] && process->last_dispatch < scheduler_queue->processes[best].last_dispatch)) {
+            best = i;
+        }
+    }
+    return best;
+}
+
+// Function to fill picked[count..] with waiting processes until slots are picked for the next round,
+// sharing them between tenants by deficit round-robin on their weights; call with the queue lock held.
+// Returns the new count, and stamps every picked process with the round. rank[] orders the waiting
+// processes inside a tenant, highest first; positions marked in taken[] and jobs still waiting on --after
+// dependencies are skipped. With by_level only each tenant's highest waiting priority level is eligible.
+// With memory-aware dispatch, processes whose working set would not fit in the round's memory budget
+// (see begin_memory_round) are held back, and so are cache-heavy processes beyond the round's cap with
+// interference-aware placement (see begin_interference_round).
+int fair_share_pick(int slots, int picked[], int count, char taken[], const long long rank[], int by_level) {
+    int waiting[MAX_TENANTS] = { 0 };
+    int level[MAX_TENANTS] = { 0 };
+    int active = 0;
+
+    // Count eligible processes per tenant; only waiting positions are visited
+    for_each_in_mask(i, scheduler_queue->waiting_mask) {
+        struct Process *process = &scheduler_queue->processes[i];
+        if (!fair_share_eligible(process) || taken[i]) {
+            continue;
+        }
+        int t = process->tenant;
+        if (by_level && level[t] != 0 && process->priority > level[t]) {
+            continue;
+        }
+        if (by_level && process->priority != level[t]) {
+            level[t] = process->priority;
+            waiting[t] = 0;
+        }
+        waiting[t]++;
+    }
+    for (int t = 0; t < scheduler_queue->tenant_count; t++) {
+        if (waiting[t] > 0) {
+            active++;
+        } else {
+            scheduler_queue->tenants[t].deficit = 0; // Idle tenants do not bank credit
+        }
+    }
+
+    while (count < slots && active > 0) {
+        int t = scheduler_queue->tenant_cursor % scheduler_queue->tenant_count;
+        struct Tenant *tenant = &scheduler_queue->tenants[t];
+
+        if (waiting[t] > 0) {
+            if (tenant->deficit < 1) {
+                tenant->deficit += tenant->weight;
+            }
+            while (tenant->deficit >= 1 && waiting[t] > 0 && count < slots) {
+                int held[2];
+                int i = pick_in_tenant(t, by_level ? level[t] : 0, rank, taken, held);
+                if (i == -1) {
+                    // Nothing else of this tenant fits in memory, or under the cache-heavy cap, this round
+                    scheduler_queue->memory_holds += held[0];
+                    scheduler_queue->interference_holds += held[1];
+                    waiting[t] = 0;
+                    tenant->deficit = 0;
+                    active--;
+                    break;
+                }
+                taken[i] = 1;
+                picked[count++] = i;
+                memory_charge(&scheduler_queue->processes[i]);
+                interference_charge(&scheduler_queue->processes[i]);
+                tenant->deficit--;
+                if (--waiting[t] == 0) {
+                    tenant->deficit = 0;
+                    active--;
+                }
+            }
+            if (count == slots && tenant->deficit >= 1) {
+                break; // This tenant's turn continues next round
+            }
+        }
+        scheduler_queue->tenant_cursor = (t + 1) % scheduler_queue->tenant_count;
+    }
+
+    scheduler_queue->tick++;
+    for (int i = 0; i < count; i++) {
+        scheduler_queue->processes[picked[i]].last_dispatch = scheduler_queue->tick;
+    }
+    return count;
+}
+
+// Function to print how much CPU time each tenant received
+void print_tenant_usage(void) {
+    if (scheduler_queue->tenant_count < 2) {
+        return;
+    }
+    printf("Tenant usage:\n");
+    for (int t = 0; t < scheduler_queue->tenant_count; t++) {
+        struct Tenant *tenant = &scheduler_queue->tenants[t];
+        printf("  %-20s weight %-4d %5d process(es) %8lld ms CPU\n",
+               tenant->name, tenant->weight, tenant->processes, tenant->usage);
+    }
+}
@@ -1,4 +1,5 @@
 #include "../include/globals.h"
+#include "../include/daemon.h"
 
 // Global variables definition
 int NCPU;
@@ -7,8 +8,11 @@ int shmid;
 
 sem_t scheduler_sem;
 sem_t print_sem;
-sem_t scheduler_queue_sem;
 
 struct ProcessQueue* scheduler_queue;
 struct ProcessQueue shell_queue;
 struct TerminatedQueue* terminated_queue;
+struct SchedulerSnapshot* status_snapshot;
+struct SchedulerConfig sched_config = { .input = "-", .batch_size = DEFAULT_BATCH_SIZE,
+                                      .psi_limit = DEFAULT_PSI_LIMIT, .socket = DEFAULT_SOCKET_PATH,
+                                      .log_cap_kb = DEFAULT_LOG_CAP_KB, .log_keep = DEFAULT_LOG_KEEP };
@@ -52,6 +52,7 @@ void show_help(void) {
     printf("   - Supports command execution, pipes, and background processes\n");
     printf("   - Commands: history, exit, any system command\n");
     printf("   - Use '&' for background execution\n");
+    printf("   - attach [socket]: queue '&' commands on a scheduler daemon (detach to stop)\n");
     printf("   - Use '|' for piped commands\n\n");
     
     printf("2. BASIC SCHEDULER (Round Robin):\n");
@@ -70,7 +71,8 @@ void show_help(void) {
     
     printf("General Commands:\n");
     printf("   - exit: Exit the current mode\n");
-    printf("   - history: Show command history (Shell mode only)\n");
+    printf("   - history: Show command history with each command's resource usage (Shell mode only)\n");
+    printf("   - history --stats [-n N] [--sort wall|cpu|rss|faults|switches|runs]: usage per program\n");
     printf("   - Ctrl+C: Exit with history display\n");
     printf("=============================\n");
 }
@@ -105,6 +107,9 @@ int run_integrated_shell(OperationMode mode) {
 
 // Main function for integrated shell
 int main(void) {
+    // Scheduler modes read fd 0 directly, so stdio must not buffer ahead of them
+    setvbuf(stdin, NULL, _IONBF, 0);
+
     printf("Welcome to the Integrated Shell-Scheduler System!\n");
     printf("Developed by Aryan Jain & Parth Rastogi - Group 8 Sec A\n");
     
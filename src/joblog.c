@@ -0,0 +1,241 @@
+#include "../include/scheduler.h"
+#include "../include/globals.h"
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/epoll.h>
+#include <sys/stat.h>
+
+#define LOG_READ_CHUNK 65536
+#define LOG_POLL_MS 200
+#define LOG_LINGER_MS 1000  // How long shutdown waits for descendants that still hold a pipe
+
+// Structure for one job whose output is being drained
+struct JobLog {
+    pid_t pid;
+    int pipe_fd;                // Read end of the job's stdout/stderr pipe
+    int file_fd;                // Current log file
+    long long size;             // Bytes in the current log file
+    struct JobLog *prev, *next;
+};
+
+static int log_epoll = -1;
+static pthread_t log_thread;
+static pthread_mutex_t log_mutex = PTHREAD_MUTEX_INITIALIZER;
+static struct JobLog *open_logs;
+static volatile int log_stopping;
+
+// Function to build the path of a job's log file; generation 0 is the live file
+static void log_path(pid_t pid, int generation, char *path, size_t size) {
+    if (generation == 0) {
+        snprintf(path, size, "%s/%d.log", sched_config.log_dir, (int)pid);
+    } else {
+        snprintf(path, size, "%s/%d.log.%d", sched_config.log_dir, (int)pid, generation);
+    }
+}
+
+// Function to open a job's live log file, truncating any left by an earlier job with the same pid
+static int open_log_file(pid_t pid) {
+    char path[PATH_MAX + 32];
+    log_path(pid, 0, path, sizeof(path));
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd == -1) {
+        perror(path);
+    }
+    return fd;
+}
+
+// Function to start a new log file once the current one reaches the cap, keeping log_keep old ones
+static void rotate_log(struct JobLog *log) {
+    char from[PATH_MAX + 32], to[PATH_MAX + 32];
+
+    close(log->file_fd);
+    if (sched_config.log_keep > 0) {
+        for (int generation = sched_config.log_keep - 1; generation >= 0; generation--) {
+            log_path(log->pid, generation, from, sizeof(from));
+            log_path(log->pid, generation + 1, to, sizeof(to));
+            rename(from, to);
+        }
+    }
+    log->file_fd = open_log_file(log->pid);
+    log->size = 0;
+}
+
+// Function to stop draining a job's output and free its record
+static void close_log(struct JobLog *log) {
+    epoll_ctl(log_epoll, EPOLL_CTL_DEL, log->pipe_fd, NULL);
+    close(log->pipe_fd);
+    if (log->file_fd != -1) {
+        close(log->file_fd);
+    }
+
+    pthread_mutex_lock(&log_mutex);
+    if (log->prev != NULL) {
+        log->prev->next = log->next;
+    } else {
+        open_logs = log->next;
+    }
+    if (log->next != NULL) {
+        log->next->prev = log->prev;
+    }
+    pthread_mutex_unlock(&log_mutex);
+    free(log);
+}
+
+// Function to copy whatever a job has written into its log file; returns -1 once every writer is gone
+static int drain_log(struct JobLog *log, char *buf) {
+    long long cap = (long long)sched_config.log_cap_kb * 1024;
+
+    while (1) {
+        ssize_t n = read(log->pipe_fd, buf, LOG_READ_CHUNK);
+        if (n == 0) {
+            return -1;
+        }
+        if (n == -1) {
+            return errno == EAGAIN || errno == EINTR ? 0 : -1;
+        }
+
+        // Output past a failed log file is still read, so the job never blocks on a full pipe
+        ssize_t done = 0;
+        while (done < n && log->file_fd != -1) {
+            ssize_t chunk = n - done;
+            if (chunk > cap - log->size) {
+                chunk = cap - log->size;
+            }
+            ssize_t written = write(log->file_fd, buf + done, chunk);
+            if (written == -1) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                perror("write (job log)");
+                close(log->file_fd);
+                log->file_fd = -1;
+                break;
+            }
+            done += written;
+            log->size += written;
+            if (log->size >= cap) {
+                rotate_log(log);
+            }
+        }
+    }
+}
+
+// Function run by the drainer thread: move job output from pipes to log files until shutdown
+static void *drain_job_logs(void *arg) {
+    (void)arg;
+    static char buf[LOG_READ_CHUNK];
+    struct epoll_event events[64];
+    long long stop_time = 0;
+
+    while (1) {
+        int ready = epoll_wait(log_epoll, events, 64, LOG_POLL_MS);
+        for (int e = 0; e < ready; e++) {
+            struct JobLog *log = events[e].data.ptr;
+            if (drain_log(log, buf) == -1) {
+                close_log(log);
+            }
+        }
+
+        if (log_stopping) {
+            pthread_mutex_lock(&log_mutex);
+            int idle = open_logs == NULL;
+            pthread_mutex_unlock(&log_mutex);
+            if (stop_time == 0) {
+                stop_time = monotonic_ms();
+            }
+            if (idle || monotonic_ms() - stop_time >= LOG_LINGER_MS) {
+                break;
+            }
+        }
+    }
+
+    // Whatever is still open belongs to descendants that outlived their job; keep what they wrote
+    while (open_logs != NULL) {
+        drain_log(open_logs, buf);
+        close_log(open_logs);
+    }
+    return NULL;
+}
+
+// Function to start capturing job output if a log directory is configured. The drainer is a thread
+// of the front-end, the process that forks the jobs and so holds their pipes; it must be started
+// after the scheduler has been forked off.
+int start_job_logs(void) {
+    if (sched_config.log_dir[0] == '\0') {
+        return 0;
+    }
+    if (mkdir(sched_config.log_dir, 0755) == -1 && errno != EEXIST) {
+        perror(sched_config.log_dir);
+        return -1;
+    }
+
+    // Every queued job holds a pipe and every draining job a log file
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max) {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+
+    log_epoll = epoll_create1(EPOLL_CLOEXEC);
+    if (log_epoll == -1) {
+        perror("epoll_create1");
+        return -1;
+    }
+
+    // The thread must not take the front-end's signals, SIGCHLD in particular
+    sigset_t all, saved;
+    sigfillset(&all);
+    pthread_sigmask(SIG_SETMASK, &all, &saved);
+    int result = pthread_create(&log_thread, NULL, drain_job_logs, NULL);
+    pthread_sigmask(SIG_SETMASK, &saved, NULL);
+    if (result != 0) {
+        fprintf(stderr, "pthread_create (job logs): %s\n", strerror(result));
+        close(log_epoll);
+        log_epoll = -1;
+        return -1;
+    }
+    return 0;
+}
+
+// Function to report whether job output is being captured
+int job_logs_enabled(void) {
+    return log_epoll != -1;
+}
+
+// Function to hand the read end of a job's output pipe to the drainer; the pipe is closed on failure
+void watch_job_output(pid_t pid, int pipe_fd) {
+    struct JobLog *log = calloc(1, sizeof(*log));
+    if (log == NULL) {
+        perror("calloc (job log)");
+        close(pipe_fd);
+        return;
+    }
+    log->pid = pid;
+    log->pipe_fd = pipe_fd;
+    log->file_fd = open_log_file(pid);
+    fcntl(pipe_fd, F_SETFL, fcntl(pipe_fd, F_GETFL) | O_NONBLOCK);
+
+    pthread_mutex_lock(&log_mutex);
+    log->next = open_logs;
+    if (open_logs != NULL) {
+        open_logs->prev = log;
+    }
+    open_logs = log;
+    pthread_mutex_unlock(&log_mutex);
+
+    struct epoll_event event = { .events = EPOLLIN, .data.ptr = log };
+    if (epoll_ctl(log_epoll, EPOLL_CTL_ADD, pipe_fd, &event) == -1) {
+        perror("epoll_ctl (job log)");
+    }
+}
+
+// Function to finish capturing once the queue has drained: wait briefly for the last output, then stop
+void stop_job_logs(void) {
+    if (log_epoll == -1) {
+        return;
+    }
+    log_stopping = 1;
+    pthread_join(log_thread, NULL);
+    close(log_epoll);
+    log_epoll = -1;
+}
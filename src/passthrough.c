@@ -0,0 +1,137 @@
+#include "../include/scheduler.h"
+#include "../include/globals.h"
+#include "../include/policy.h"
+#include <sched.h>
+#include <stdint.h>
+#include <sys/syscall.h>
+
+// Argument of sched_setattr(2), which glibc does not wrap
+struct kernel_sched_attr {
+    uint32_t size;
+    uint32_t sched_policy;
+    uint64_t sched_flags;
+    int32_t sched_nice;
+    uint32_t sched_priority;
+    uint64_t sched_runtime;
+    uint64_t sched_deadline;
+    uint64_t sched_period;
+};
+
+// Kernel policy and nice value for each priority level (index 0 is unused)
+static const struct {
+    int policy;
+    int nice;
+} kernel_levels[5] = {
+    { SCHED_OTHER, 0 },
+    { SCHED_OTHER, 0 },     // 1: interactive work at the normal weight
+    { SCHED_OTHER, 5 },     // 2: about a third of the CPU of level 1 when they compete
+    { SCHED_BATCH, 10 },    // 3: throughput work, no wake-up preemption
+    { SCHED_IDLE, 19 },     // 4: only runs on otherwise idle CPUs
+};
+
+// Function to hand a process's priority level to the kernel scheduler
+int apply_kernel_priority(pid_t pid, int level) {
+    struct kernel_sched_attr attr;
+
+    if (level < 1 || level > 4) {
+        level = 1;
+    }
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.sched_policy = kernel_levels[level].policy;
+    attr.sched_nice = kernel_levels[level].nice;
+    if (syscall(SYS_sched_setattr, pid, &attr, 0) == -1) {
+        // Older kernels: fall back to the classic calls
+        struct sched_param param = { 0 };
+        if (sched_setscheduler(pid, kernel_levels[level].policy, &param) == -1 ||
+            setpriority(PRIO_PROCESS, pid, kernel_levels[level].nice) == -1) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// Function to change the priority level of a queued process; returns -1 if it is unknown, or -2 with
+// errno set if the kernel refused the new level, in which case the process keeps its old one.
+// In passthrough mode a process that has already been started is re-tagged in the kernel, along
+// with every thread of everything else in its process group (processes it forks later inherit the
+// setting).
+int reprioritise_job(pid_t pid, int level) {
+    int result = -1;
+    int saved_errno = 0;
+
+    lock_scheduler_queue();
+    int i = find_process(pid);
+    if (i != -1) {
+        struct Process *process = &scheduler_queue->processes[i];
+        result = 0;
+        if (sched_config.passthrough && (process->state == 0 || process->state == 2)) {
+            pid_t threads[MAX_GROUP_MEMBERS];
+            int count = list_group_threads(pid, threads, MAX_GROUP_MEMBERS);
+            int applied = 0;
+            while (applied < count) {
+                if (apply_kernel_priority(threads[applied], level) == -1 && errno != ESRCH) {
+                    saved_errno = errno;
+                    result = -2;
+                    break;
+                }
+                applied++;
+            }
+            // Raising a level usually needs CAP_SYS_NICE: put back the threads already changed
+            for (int t = 0; result == -2 && t < applied; t++) {
+                apply_kernel_priority(threads[t], process->priority);
+            }
+        }
+        if (result == 0) {
+            process->priority = level;
+        }
+    }
+    unlock_scheduler_queue();
+    errno = saved_errno;
+    return result;
+}
+
+// Scheduler loop for passthrough mode: start at most NCPU processes and leave CPU sharing between them
+// to the kernel. Processes are never stopped once started; the loop only wakes for new submissions,
+// or every TSLICE to refill the slots of processes that have finished.
+void run_passthrough_scheduler(void) {
+    int picked[MAX_PROCESSES];
+
+    while (1) {
+        if (sched_config.memory_aware) {
+            sample_jobs(1); // Working sets for the memory budget, read outside the lock
+        } else {
+            sample_job_counters();
+        }
+        sample_host_load();
+        lock_scheduler_queue();
+        attach_job_samples();
+        int running = count_in_mask(scheduler_queue->running_mask) + count_in_mask(scheduler_queue->blocked_mask);
+        int slots = begin_memory_round(update_slots());
+        begin_interference_round();
+        policy_on_tick(monotonic_ms());
+        if (running < slots) {
+            int count = policy_pick_next(slots - running, picked);
+            for (int n = 0; n < count; n++) {
+                struct Process *process = &scheduler_queue->processes[picked[n]];
+                if (apply_kernel_priority(process->pid, process->priority) == -1) {
+                    perror("sched_setattr");
+                }
+            }
+            start_jobs(picked, count);
+        }
+        note_jobs_to_sample();
+        unlock_scheduler_queue();
+
+        struct timespec wake;
+        clock_gettime(CLOCK_REALTIME, &wake);
+        wake.tv_sec += TSLICE / 1000;
+        wake.tv_nsec += (long)(TSLICE % 1000) * 1000000;
+        if (wake.tv_nsec >= 1000000000) {
+            wake.tv_sec++;
+            wake.tv_nsec -= 1000000000;
+        }
+        while (sem_timedwait(&scheduler_sem, &wake) == -1 && errno == EINTR) {
+        }
+    }
+}
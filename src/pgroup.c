@@ -0,0 +1,355 @@
+#include "../include/pgroup.h"
+#include <ctype.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define GROUP_RESCAN_MS 100     // Without children lists, how often /proc is scanned for new members
+#define MAX_SCANNED 4096
+
+// Structure for the fields of /proc/<pid>/stat used here
+struct ProcStat {
+    char state;
+    pid_t pgrp;
+    long long self_ticks;       // utime + stime
+    long long children_ticks;   // cutime + cstime of reaped children
+    int threads;
+};
+
+// Structure for a member found by walking a job's process tree
+struct GroupMember {
+    pid_t pid;
+    struct ProcStat stat;       // Its state is that of its most active thread
+};
+
+// Kernels without CONFIG_PROC_CHILDREN have no children lists to walk: members are then found by a
+// scan of /proc for the groups asked about, repeated at most every GROUP_RESCAN_MS or when a new group
+// is asked about, and between scans only the members it found are re-read
+static int children_lists = -1;     // Whether /proc/<pid>/task/<tid>/children exists, -1 until checked
+static pid_t scanned_leaders[MAX_GROUP_MEMBERS];
+static int scanned_leader_count;
+static pid_t scanned_pids[MAX_SCANNED];
+static pid_t scanned_pgrps[MAX_SCANNED];
+static int scanned_count;
+static long long scanned_ms;
+
+// Function to read a small /proc file into buf; returns its length or -1
+static int read_small_file(const char *path, char *buf, size_t size) {
+    int fd = open(path, O_RDONLY);
+    if (fd == -1) {
+        return -1;
+    }
+    ssize_t n = read(fd, buf, size - 1);
+    close(fd);
+    if (n < 0) {
+        return -1;
+    }
+    buf[n] = '\0';
+    return (int)n;
+}
+
+// Function to parse a /proc/<pid>/stat or /proc/<pid>/task/<tid>/stat file; returns -1 if the task is gone
+static int read_proc_stat(const char *path, struct ProcStat *stat) {
+    char buf[512];
+    if (read_small_file(path, buf, sizeof(buf)) == -1) {
+        return -1;
+    }
+
+    // The command name may contain spaces or parentheses; the fields resume after the last ')'
+    char *paren = strrchr(buf, ')');
+    int pgrp;
+    unsigned long long utime, stime;
+    long long cutime, cstime;
+    if (paren == NULL ||
+        sscanf(paren + 2, "%c %*d %d %*d %*d %*d %*u %*u %*u %*u %*u %llu %llu %lld %lld %*d %*d %d",
+               &stat->state, &pgrp, &utime, &stime, &cutime, &cstime, &stat->threads) != 7) {
+        return -1;
+    }
+    stat->pgrp = (pid_t)pgrp;
+    stat->self_ticks = (long long)(utime + stime);
+    stat->children_ticks = cutime + cstime;
+    return 0;
+}
+
+// Function to read a process's own CPU time in ns from /proc/<pid>/schedstat, or -1 without schedstats
+static long long read_schedstat_ns(pid_t pid) {
+    char path[64], buf[128];
+    long long run_ns;
+    snprintf(path, sizeof(path), "/proc/%d/schedstat", (int)pid);
+    if (read_small_file(path, buf, sizeof(buf)) == -1 || sscanf(buf, "%lld", &run_ns) != 1) {
+        return -1;
+    }
+    return run_ns;
+}
+
+// Function to read a process's resident set in pages from /proc/<pid>/statm, or -1 if it is gone
+static long read_resident_pages(pid_t pid) {
+    char path[64], buf[128];
+    long size, resident;
+    snprintf(path, sizeof(path), "/proc/%d/statm", (int)pid);
+    if (read_small_file(path, buf, sizeof(buf)) == -1 || sscanf(buf, "%ld %ld", &size, &resident) != 2) {
+        return -1;
+    }
+    return resident;
+}
+
+// Function to rank task states so a group shows its most active member's state
+static int state_rank(char state) {
+    switch (state) {
+        case 'R':
+            return 4;
+        case 'D':
+            return 3;
+        case 'S':
+            return 2;
+        case 'T':
+        case 't':
+            return 1;
+        default:
+            return 0;   // Zombies and unknown states say nothing about the group
+    }
+}
+
+// Function to add the children one thread of a member has forked to members[], keeping those still in
+// the job's process group; returns the new member count
+static int add_children(const char *path, pid_t leader, struct GroupMember members[], int count, int max) {
+    char buf[4096];
+    int length = read_small_file(path, buf, sizeof(buf));
+    if (length == -1) {
+        return count;
+    }
+    if (length == (int)sizeof(buf) - 1) {
+        // Too many children to read at once: drop the pid the read cut short
+        char *last = strrchr(buf, ' ');
+        *(last != NULL ? last : buf) = '\0';
+    }
+
+    char *cursor = buf;
+    while (count < max) {
+        char *end;
+        long child = strtol(cursor, &end, 10);
+        if (end == cursor) {
+            break;
+        }
+        cursor = end;
+
+        char stat_path[64];
+        snprintf(stat_path, sizeof(stat_path), "/proc/%ld/stat", child);
+        if (read_proc_stat(stat_path, &members[count].stat) == 0 && members[count].stat.pgrp == leader) {
+            members[count++].pid = (pid_t)child;
+        }
+    }
+    return count;
+}
+
+// Function to check once whether the kernel has children lists
+static int have_children_lists(void) {
+    if (children_lists == -1) {
+        char path[64];
+        snprintf(path, sizeof(path), "/proc/%d/task/%d/children", (int)getpid(), (int)getpid());
+        children_lists = access(path, R_OK) == 0;
+    }
+    return children_lists;
+}
+
+// Function to check whether a pid is in a list
+static int pid_listed(pid_t pid, const pid_t list[], int count) {
+    for (int n = 0; n < count; n++) {
+        if (list[n] == pid) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Function to scan /proc for the members of the given groups other than their leaders, unless the last
+// scan covered every one of them and is recent enough
+static void refresh_scan(const pid_t leaders[], int count) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    long long now_ms = (long long)now.tv_sec * 1000 + now.tv_nsec / 1000000;
+
+    int covered = now_ms - scanned_ms < GROUP_RESCAN_MS;
+    for (int g = 0; covered && g < count; g++) {
+        covered = pid_listed(leaders[g], scanned_leaders, scanned_leader_count);
+    }
+    if (covered) {
+        return;
+    }
+
+    scanned_ms = now_ms;
+    scanned_count = 0;
+    scanned_leader_count = count < MAX_GROUP_MEMBERS ? count : MAX_GROUP_MEMBERS;
+    memcpy(scanned_leaders, leaders, scanned_leader_count * sizeof(pid_t));
+    DIR *proc = opendir("/proc");
+    if (proc == NULL) {
+        return;
+    }
+    struct dirent *entry;
+    while (scanned_count < MAX_SCANNED && (entry = readdir(proc)) != NULL) {
+        char path[64];
+        struct ProcStat stat;
+        if (!isdigit((unsigned char)entry->d_name[0])) {
+            continue;
+        }
+        pid_t pid = (pid_t)atoi(entry->d_name);
+        snprintf(path, sizeof(path), "/proc/%d/stat", (int)pid);
+        if (read_proc_stat(path, &stat) == 0 && stat.pgrp != pid &&
+            pid_listed(stat.pgrp, scanned_leaders, scanned_leader_count)) {
+            scanned_pids[scanned_count] = pid;
+            scanned_pgrps[scanned_count++] = stat.pgrp;
+        }
+    }
+    closedir(proc);
+}
+
+// Function to add the members the last scan found in a job's group to members[], keeping those still
+// in it; returns the new member count
+static int add_scanned_members(pid_t leader, struct GroupMember members[], int count, int max) {
+    for (int n = 0; n < scanned_count && count < max; n++) {
+        char path[64];
+        if (scanned_pgrps[n] != leader) {
+            continue;
+        }
+        snprintf(path, sizeof(path), "/proc/%d/stat", (int)scanned_pids[n]);
+        if (read_proc_stat(path, &members[count].stat) == 0 && members[count].stat.pgrp == leader) {
+            members[count++].pid = scanned_pids[n];
+        }
+    }
+    return count;
+}
+
+// Function to walk a job's process tree breadth first from its leader, whose pid is the group id,
+// collecting the members still in the group; the state of a multi-threaded member is taken from all of
+// its threads, since a pool's main thread often just waits in pthread_join while its workers run.
+// Returns how many members were stored, 0 if the leader is gone.
+static int walk_group(pid_t leader, struct GroupMember members[], int max) {
+    char path[96];
+    int count = 0;
+
+    snprintf(path, sizeof(path), "/proc/%d/stat", (int)leader);
+    if (max > 0 && read_proc_stat(path, &members[0].stat) == 0 && members[0].stat.pgrp == leader) {
+        members[0].pid = leader;
+        count = 1;
+    }
+    int walk_children = have_children_lists();
+    if (count > 0 && !walk_children) {
+        count = add_scanned_members(leader, members, count, max);
+    }
+    for (int n = 0; n < count; n++) {
+        struct GroupMember *member = &members[n];
+        if (member->stat.threads <= 1) {
+            if (walk_children) {
+                snprintf(path, sizeof(path), "/proc/%d/task/%d/children", (int)member->pid, (int)member->pid);
+                count = add_children(path, leader, members, count, max);
+            }
+            continue;
+        }
+
+        // Children belong to the thread that forked them
+        snprintf(path, sizeof(path), "/proc/%d/task", (int)member->pid);
+        DIR *tasks = opendir(path);
+        if (tasks == NULL) {
+            continue;
+        }
+        struct dirent *entry;
+        while ((entry = readdir(tasks)) != NULL) {
+            struct ProcStat thread;
+            if (!isdigit((unsigned char)entry->d_name[0])) {
+                continue;
+            }
+            int tid = atoi(entry->d_name);
+            snprintf(path, sizeof(path), "/proc/%d/task/%d/stat", (int)member->pid, tid);
+            if (read_proc_stat(path, &thread) == 0 && state_rank(thread.state) > state_rank(member->stat.state)) {
+                member->stat.state = thread.state;
+            }
+            if (walk_children) {
+                snprintf(path, sizeof(path), "/proc/%d/task/%d/children", (int)member->pid, tid);
+                count = add_children(path, leader, members, count, max);
+            }
+        }
+        closedir(tasks);
+    }
+    return count;
+}
+
+// Function to sample several jobs' process groups, walking each from its leader. Members' own CPU time
+// comes from schedstat where available (it only covers the main thread, so multi-threaded members use
+// utime/stime); children they have already reaped are counted from cutime/cstime. With with_rss the
+// members' resident sets are summed as well. Returns how many of the groups had at least one live member.
+int sample_process_groups(const pid_t leaders[], int count, struct GroupSample samples[], int with_rss) {
+    struct GroupMember members[MAX_GROUP_MEMBERS];
+    long long tick_ns = 1000000000LL / sysconf(_SC_CLK_TCK);
+    long page_kb = sysconf(_SC_PAGESIZE) / 1024;
+    int found = 0;
+
+    if (!have_children_lists()) {
+        refresh_scan(leaders, count);
+    }
+    for (int g = 0; g < count; g++) {
+        samples[g].state = '?';
+        samples[g].cpu_ns = 0;
+        samples[g].rss_kb = 0;
+        samples[g].members = walk_group(leaders[g], members, MAX_GROUP_MEMBERS);
+        if (samples[g].members > 0) {
+            found++;
+        }
+
+        for (int m = 0; m < samples[g].members; m++) {
+            struct ProcStat *stat = &members[m].stat;
+            long long self_ns = stat->threads == 1 ? read_schedstat_ns(members[m].pid) : -1;
+            if (self_ns < 0) {
+                self_ns = stat->self_ticks * tick_ns;
+            }
+            samples[g].cpu_ns += self_ns + stat->children_ticks * tick_ns;
+            if (with_rss) {
+                long resident = read_resident_pages(members[m].pid);
+                samples[g].rss_kb += resident > 0 ? resident * page_kb : 0;
+            }
+            if (state_rank(stat->state) > state_rank(samples[g].state)) {
+                samples[g].state = stat->state == 't' ? 'T' : stat->state;
+            }
+        }
+    }
+    return found;
+}
+
+// Function to list the threads of a job's live group members, for changes such as sched_setattr() that
+// apply to one thread at a time; returns how many were stored
+int list_group_threads(pid_t leader, pid_t tids[], int max) {
+    struct GroupMember members[MAX_GROUP_MEMBERS];
+    if (!have_children_lists()) {
+        refresh_scan(&leader, 1);
+    }
+    int member_count = walk_group(leader, members, MAX_GROUP_MEMBERS);
+    int count = 0;
+
+    for (int m = 0; m < member_count && count < max; m++) {
+        if (members[m].stat.state == 'Z') {
+            continue;
+        }
+        if (members[m].stat.threads <= 1) {
+            tids[count++] = members[m].pid;
+            continue;
+        }
+
+        char path[64];
+        snprintf(path, sizeof(path), "/proc/%d/task", (int)members[m].pid);
+        DIR *tasks = opendir(path);
+        if (tasks == NULL) {
+            continue;
+        }
+        struct dirent *entry;
+        while (count < max && (entry = readdir(tasks)) != NULL) {
+            if (isdigit((unsigned char)entry->d_name[0])) {
+                tids[count++] = (pid_t)atoi(entry->d_name);
+            }
+        }
+        closedir(tasks);
+    }
+    return count;
+}
@@ -0,0 +1,37 @@
+#include "../include/scheduler.h"
+#include "../include/globals.h"
+#include "../include/policy.h"
+
+// Round-robin and priority policies. Tenants share the slots by weight; inside a tenant the job heading
+// the longest estimated chain of --after dependents goes first, then the least recently run. Under the
+// priority policy only each tenant's highest waiting level is eligible.
+
+// Function to pick the next round's jobs round-robin
+int rr_pick_next(int slots, int picked[]) {
+    static long long rank[MAX_PROCESSES];
+    char taken[MAX_PROCESSES] = { 0 };
+
+    rank_by_critical_path(rank);
+    return fair_share_pick(slots, picked, 0, taken, rank, 0);
+}
+
+// Function to pick the next round's jobs from each tenant's highest waiting priority level
+int priority_pick_next(int slots, int picked[]) {
+    static long long rank[MAX_PROCESSES];
+    char taken[MAX_PROCESSES] = { 0 };
+
+    rank_by_critical_path(rank);
+    return fair_share_pick(slots, picked, 0, taken, rank, 1);
+}
+
+// Function to size a priority round: TSLICE divided by the highest priority level picked (1 is highest)
+int priority_slice_ms(const int picked[], int count) {
+    int flag = 0;
+    for (int n = 0; n < count; n++) {
+        struct Process *process = &scheduler_queue->processes[picked[n]];
+        if (flag == 0 || process->priority < flag) {
+            flag = process->priority;
+        }
+    }
+    return flag != 0 ? TSLICE / flag : TSLICE;
+}
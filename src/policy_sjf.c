@@ -0,0 +1,35 @@
+#include "../include/scheduler.h"
+#include "../include/globals.h"
+#include "../include/policy.h"
+
+// Shortest-first policies, ranked by the runtime model (runtime.c): srpt by the work a job has left, as
+// it last reported through progress.h or as predicted, sjf by its whole predicted run time. Jobs that are
+// confidently expected to finish within two slices are given a sized quantum (see job_quantum).
+
+// Function to pick the next round's jobs, least remaining work first
+int srpt_pick_next(int slots, int picked[]) {
+    static long long rank[MAX_PROCESSES];
+    char taken[MAX_PROCESSES] = { 0 };
+
+    for_each_in_mask(i, scheduler_queue->waiting_mask) {
+        rank[i] = -remaining_estimate(&scheduler_queue->processes[i]);
+    }
+    return fair_share_pick(slots, picked, 0, taken, rank, 0);
+}
+
+// Function to pick the next round's jobs, shortest predicted run time first
+int sjf_pick_next(int slots, int picked[]) {
+    static long long rank[MAX_PROCESSES];
+    char taken[MAX_PROCESSES] = { 0 };
+
+    for_each_in_mask(i, scheduler_queue->waiting_mask) {
+        rank[i] = -total_estimate(&scheduler_queue->processes[i]);
+    }
+    return fair_share_pick(slots, picked, 0, taken, rank, 0);
+}
+
+// Function to end the sized quantum of a job that blocked: the quantum assumed it would compute straight
+// through, so once it wakes it is stopped with the round like any other job
+void sized_on_block(int i) {
+    scheduler_queue->processes[i].quantum_end = 0;
+}
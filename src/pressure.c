@@ -0,0 +1,119 @@
+#include "../include/scheduler.h"
+#include "../include/globals.h"
+
+// Memory budget for the round being picked
+static long long budget_kb;
+static long long charged_kb;
+static int charged_count;
+static int memory_slots = MAX_PROCESSES; // Concurrency allowed while the host is under pressure
+
+// Function to read the avg10 figure of one line ("some" or "full") of a /proc/pressure file
+static double read_psi_avg10(const char *path, const char *kind) {
+    FILE *file = fopen(path, "r");
+    if (file == NULL) {
+        return 0.0; // Kernel without PSI: rely on RSS fitting alone
+    }
+
+    char line[256];
+    double avg10 = 0.0;
+    size_t kind_len = strlen(kind);
+    while (fgets(line, sizeof(line), file) != NULL) {
+        if (strncmp(line, kind, kind_len) == 0 && line[kind_len] == ' ') {
+            char *field = strstr(line, "avg10=");
+            if (field != NULL) {
+                avg10 = atof(field + 6);
+            }
+            break;
+        }
+    }
+    fclose(file);
+    return avg10;
+}
+
+// Function to read a field of /proc/meminfo in kB
+static long long read_meminfo_kb(const char *name) {
+    FILE *file = fopen("/proc/meminfo", "r");
+    if (file == NULL) {
+        return -1;
+    }
+
+    char line[256];
+    long long value = -1;
+    size_t name_len = strlen(name);
+    while (fgets(line, sizeof(line), file) != NULL) {
+        if (strncmp(line, name, name_len) == 0 && line[name_len] == ':') {
+            value = atoll(line + name_len + 1);
+            break;
+        }
+    }
+    fclose(file);
+    return value;
+}
+
+// Function to sample host pressure before a round is picked; call with the queue lock held, after
+// attach_job_samples() has updated each job's working set (the peak RSS of its whole process group) from
+// a sample_jobs(1) taken outside the lock. Returns how many slots may be filled this round.
+int begin_memory_round(int slots) {
+    if (!sched_config.memory_aware) {
+        return slots;
+    }
+
+    // The jobs holding or parked with a slot, however they got it: picked at the start of the last
+    // round or refilled into a slot a blocked job released during it
+    uint64_t active[QUEUE_MASK_WORDS];
+    long long last_round_kb = 0;
+    for (int w = 0; w < QUEUE_MASK_WORDS; w++) {
+        active[w] = scheduler_queue->running_mask[w] | scheduler_queue->blocked_mask[w];
+    }
+    for_each_in_mask(i, active) {
+        last_round_kb += scheduler_queue->processes[i].rss_kb;
+    }
+
+    // The jobs that just ran hold their pages; anything beyond must come out of MemAvailable
+    long long available = read_meminfo_kb("MemAvailable");
+    long long total = read_meminfo_kb("MemTotal");
+    if (available < 0 || total <= 0) {
+        budget_kb = -1; // No meminfo: do not limit by RSS
+    } else {
+        budget_kb = available + last_round_kb - total / 20; // Keep 5% in reserve
+    }
+    charged_kb = 0;
+    charged_count = 0;
+
+    // Halve concurrency while memory or I/O is stalling, and grow back one slot per calm round
+    double memory_stall = read_psi_avg10("/proc/pressure/memory", "some");
+    double io_stall = read_psi_avg10("/proc/pressure/io", "full");
+    if (memory_stall > sched_config.psi_limit || io_stall > sched_config.psi_limit) {
+        int allowed = (memory_slots < slots ? memory_slots : slots) / 2;
+        memory_slots = allowed > 1 ? allowed : 1;
+        scheduler_queue->pressure_rounds++;
+    } else if (memory_slots < slots) {
+        memory_slots++;
+    } else {
+        memory_slots = slots;
+    }
+    return memory_slots < slots ? memory_slots : slots;
+}
+
+// Function to check whether a job's working set fits in the rest of this round's memory budget
+int memory_fits(const struct Process *process) {
+    if (!sched_config.memory_aware || budget_kb < 0 || charged_count == 0) {
+        return 1; // The first job of a round always runs so the queue keeps moving
+    }
+    return charged_kb + process->rss_kb <= budget_kb;
+}
+
+// Function to charge a picked job's working set to this round's memory budget
+void memory_charge(const struct Process *process) {
+    charged_kb += process->rss_kb;
+    charged_count++;
+}
+
+// Function to print what memory-aware dispatch held back
+void print_memory_summary(void) {
+    if (!sched_config.memory_aware) {
+        return;
+    }
+    printf("Memory-aware dispatch: %lld round(s) under pressure, %lld dispatch(es) held back for memory\n",
+           scheduler_queue->pressure_rounds, scheduler_queue->memory_holds);
+}
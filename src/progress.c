@@ -0,0 +1,173 @@
+#include "../include/progress.h"
+#include <sched.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+static struct ProgressTable *table;
+static struct ProgressSlot *own_slot;  // Job side: this job's slot once attached
+static int attach_tried;
+
+// Function to map the table behind a descriptor; returns NULL if it is not a progress table
+static struct ProgressTable *map_table(int fd) {
+    struct stat st;
+    if (fstat(fd, &st) == -1 || st.st_size < (off_t)sizeof(struct ProgressTable)) {
+        return NULL;
+    }
+    struct ProgressTable *mapped = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (mapped == MAP_FAILED) {
+        return NULL;
+    }
+    if (mapped->magic != PROGRESS_MAGIC ||
+        sizeof(*mapped) + mapped->slot_count * sizeof(struct ProgressSlot) > (size_t)st.st_size) {
+        munmap(mapped, st.st_size);
+        return NULL;
+    }
+    return mapped;
+}
+
+// Function to find this job's slot in the scheduler's table; returns -1 when not run by the scheduler.
+// Any process in the job's process group reports into the job's slot.
+int progress_attach(void) {
+    if (attach_tried) {
+        return own_slot != NULL ? 0 : -1;
+    }
+    attach_tried = 1;
+
+    const char *fd_text = getenv(PROGRESS_FD_ENV);
+    if (fd_text == NULL || (table = map_table(atoi(fd_text))) == NULL) {
+        return -1;
+    }
+    pid_t pgid = getpgrp();
+    for (int s = 0; s < table->slot_count; s++) {
+        if (__atomic_load_n(&table->slots[s].pgid, __ATOMIC_ACQUIRE) == pgid) {
+            own_slot = &table->slots[s];
+            return 0;
+        }
+    }
+    return -1;
+}
+
+// Function to get the CPU time this process has used, in ms
+static long long cpu_time_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return (long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+// Function to report units of work done out of total; the remaining CPU time is estimated from the
+// rate so far, so units need not take equal time on average for a rough ordering to come out right
+void progress_report(long long done, long long total) {
+    if (progress_attach() == -1) {
+        return;
+    }
+    long long remaining = -1;
+    if (done > 0 && total >= done) {
+        remaining = cpu_time_ms() * (total - done) / done;
+    }
+    __atomic_store_n(&own_slot->done, done, __ATOMIC_RELAXED);
+    __atomic_store_n(&own_slot->total, total, __ATOMIC_RELAXED);
+    __atomic_store_n(&own_slot->remaining_ms, remaining, __ATOMIC_RELEASE);
+}
+
+// Function to report the job's own estimate of the CPU time it still needs, in ms
+void progress_remaining(long long remaining_ms) {
+    if (progress_attach() == -1) {
+        return;
+    }
+    __atomic_store_n(&own_slot->remaining_ms, remaining_ms < 0 ? -1 : remaining_ms, __ATOMIC_RELEASE);
+}
+
+// Function to give up the CPU at a safe point. Under a scheduler that supports it the job stops
+// itself; the scheduler sees that, gives its slot to another job and resumes this one when it is
+// picked again. Anywhere else this only yields to the kernel scheduler.
+void progress_yield(void) {
+    if (progress_attach() == -1 || !table->yield_supported) {
+        sched_yield();
+        return;
+    }
+    __atomic_store_n(&own_slot->yielding, 1, __ATOMIC_RELEASE);
+    raise(SIGSTOP);
+    __atomic_store_n(&own_slot->yielding, 0, __ATOMIC_RELEASE);
+}
+
+// Function to create the table before the scheduler forks and export it to every job it starts.
+// The table lives in an anonymous memfd whose descriptor jobs inherit, so nothing is left behind.
+int create_progress_table(int slot_count, int yield_supported) {
+    size_t size = sizeof(struct ProgressTable) + slot_count * sizeof(struct ProgressSlot);
+    int fd = memfd_create("shell-scheduler-progress", 0);
+    if (fd == -1) {
+        perror("memfd_create (progress)");
+        return -1;
+    }
+    if (ftruncate(fd, size) == -1) {
+        perror("ftruncate (progress)");
+        close(fd);
+        return -1;
+    }
+    table = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (table == MAP_FAILED) {
+        perror("mmap (progress)");
+        table = NULL;
+        close(fd);
+        return -1;
+    }
+    table->slot_count = slot_count;
+    table->yield_supported = yield_supported;
+    for (int s = 0; s < slot_count; s++) {
+        table->slots[s].remaining_ms = -1;
+    }
+    table->magic = PROGRESS_MAGIC;
+
+    char fd_text[16];
+    snprintf(fd_text, sizeof(fd_text), "%d", fd);
+    setenv(PROGRESS_FD_ENV, fd_text, 1);
+    return 0;
+}
+
+// Function to give a new job a slot before it first runs; returns the slot or -1 if there is none
+int claim_progress_slot(pid_t pgid) {
+    if (table == NULL) {
+        return -1;
+    }
+    for (int s = 0; s < table->slot_count; s++) {
+        struct ProgressSlot *slot = &table->slots[s];
+        if (slot->pgid == 0) {
+            slot->yielding = 0;
+            slot->done = 0;
+            slot->total = 0;
+            slot->remaining_ms = -1;
+            __atomic_store_n(&slot->pgid, pgid, __ATOMIC_RELEASE);
+            return s;
+        }
+    }
+    return -1;
+}
+
+// Function to free a finished job's slot
+void release_progress_slot(int slot) {
+    if (table != NULL && slot >= 0) {
+        __atomic_store_n(&table->slots[slot].pgid, 0, __ATOMIC_RELEASE);
+    }
+}
+
+// Function to get the remaining CPU time a job last reported, in ms, or -1 if it has not reported
+long long reported_remaining_ms(int slot) {
+    if (table == NULL || slot < 0) {
+        return -1;
+    }
+    return __atomic_load_n(&table->slots[slot].remaining_ms, __ATOMIC_ACQUIRE);
+}
+
+// Function to check whether a job has stopped itself with progress_yield()
+int progress_yielded(int slot) {
+    if (table == NULL || slot < 0) {
+        return 0;
+    }
+    return __atomic_load_n(&table->slots[slot].yielding, __ATOMIC_ACQUIRE);
+}
@@ -0,0 +1,114 @@
+#include "../include/protocol.h"
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netdb.h>
+
+// Function to send one message, writing the whole frame; returns -1 on error
+int send_message(int fd, MessageType type, uint32_t job, uint32_t a, uint32_t b, const char *text) {
+    unsigned char frame[MESSAGE_HEADER_SIZE + MESSAGE_FIELDS_SIZE + MAX_LINE];
+    size_t text_len = text != NULL ? strlen(text) : 0;
+    uint32_t fields[5];
+
+    if (text_len >= MAX_LINE) {
+        errno = EMSGSIZE;
+        return -1;
+    }
+    fields[0] = htonl((uint32_t)(MESSAGE_FIELDS_SIZE + text_len));
+    fields[1] = htonl((uint32_t)type << 16); // Type in the high half, reserved half zero
+    fields[2] = htonl(job);
+    fields[3] = htonl(a);
+    fields[4] = htonl(b);
+    memcpy(frame, fields, sizeof(fields));
+    if (text_len > 0) {
+        memcpy(frame + sizeof(fields), text, text_len);
+    }
+
+    size_t total = sizeof(fields) + text_len;
+    size_t sent = 0;
+    while (sent < total) {
+        ssize_t n = send(fd, frame + sent, total - sent, MSG_NOSIGNAL);
+        if (n == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        sent += n;
+    }
+    return 0;
+}
+
+// Function to take the next complete message from a reader; returns 1 for a message,
+// 0 if more input is needed, -1 at end of input or on a malformed frame
+int next_message(struct LineReader *reader, struct Message *msg) {
+    size_t avail = reader->len - reader->start;
+    uint32_t fields[5];
+
+    if (avail < MESSAGE_HEADER_SIZE + MESSAGE_FIELDS_SIZE) {
+        return reader->eof ? -1 : 0;
+    }
+    memcpy(fields, reader->buf + reader->start, sizeof(fields));
+    uint32_t length = ntohl(fields[0]);
+    if (length < MESSAGE_FIELDS_SIZE || length - MESSAGE_FIELDS_SIZE >= MAX_LINE) {
+        fprintf(stderr, "Malformed message of %u bytes\n", length);
+        return -1;
+    }
+    if (avail < MESSAGE_HEADER_SIZE + length) {
+        return reader->eof ? -1 : 0;
+    }
+
+    size_t text_len = length - MESSAGE_FIELDS_SIZE;
+    msg->type = (MessageType)(ntohl(fields[1]) >> 16);
+    msg->job = ntohl(fields[2]);
+    msg->a = ntohl(fields[3]);
+    msg->b = ntohl(fields[4]);
+    memcpy(msg->text, reader->buf + reader->start + sizeof(fields), text_len);
+    msg->text[text_len] = '\0';
+
+    reader->start += MESSAGE_HEADER_SIZE + length;
+    if (reader->start == reader->len) {
+        reader->start = 0;
+        reader->len = 0;
+    }
+    return 1;
+}
+
+// Function to parse "host:port", "host" or "port" into an IPv4 address; returns -1 if invalid
+int parse_endpoint(const char *text, struct sockaddr_in *addr) {
+    char host[256] = "0.0.0.0";
+    const char *port = text;
+    const char *colon = strrchr(text, ':');
+
+    if (colon != NULL) {
+        if ((size_t)(colon - text) >= sizeof(host)) {
+            return -1;
+        }
+        memcpy(host, text, colon - text);
+        host[colon - text] = '\0';
+        port = colon + 1;
+    } else if (strspn(text, "0123456789") != strlen(text)) {
+        if (strlen(text) >= sizeof(host)) {
+            return -1;
+        }
+        strcpy(host, text);
+        port = "";
+    }
+
+    char *end;
+    long number = *port != '\0' ? strtol(port, &end, 10) : DEFAULT_PORT;
+    if (*port != '\0' && (*end != '\0' || number <= 0 || number > 65535)) {
+        return -1;
+    }
+
+    struct addrinfo hints, *result;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    if (getaddrinfo(host, NULL, &hints, &result) != 0) {
+        return -1;
+    }
+    memcpy(addr, result->ai_addr, sizeof(*addr));
+    freeaddrinfo(result);
+    addr->sin_port = htons((uint16_t)number);
+    return 0;
+}
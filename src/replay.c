@@ -0,0 +1,454 @@
+#include "../include/command.h"
+#include "../include/trace.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <signal.h>
+#include <time.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+
+#define MAX_RUNS 8
+
+// Structure for one job as seen in a trace
+struct TraceJob {
+    int id;
+    long long submit_ms;
+    long long exit_ms;          // -1 if the trace has no exit for it
+    int code;                   // As recorded in the exit line
+    long long cpu_ms;
+    char after[MAX_LINE];       // --after list as recorded, "-" for none
+    char line[MAX_LINE];        // Submit options and command
+};
+
+// Structure for the metrics compared between runs
+struct TraceMetrics {
+    int submitted;
+    int finished;
+    int failed;                 // Finished with a nonzero code, a signal, or cancelled
+    long long makespan_ms;      // First submission to last exit
+    double throughput;          // Finished jobs per second of makespan
+    double mean_turnaround;
+    long long p50, p95, p99, max_turnaround;
+    long long cpu_ms;
+};
+
+// Function to print replay usage
+static void print_usage(const char *prog) {
+    printf("Usage: %s [-x speed] [-o dir] trace [-- scheduler [options...]]...\n", prog);
+    printf("  Prints the metrics of a trace recorded with --record. Each scheduler command line after --\n");
+    printf("  is started as a daemon, sent the trace's submissions with their original spacing divided\n");
+    printf("  by speed, and recorded in turn; the runs are then compared side by side with the trace.\n");
+    printf("  -x, speed   Replay speed factor (default 1; 2 submits twice as fast)\n");
+    printf("  -o, dir     Directory for each run's trace and output (default /tmp)\n");
+}
+
+// Function to load a trace; returns the number of jobs, or -1 if it cannot be read
+static int load_trace(const char *path, struct TraceJob **jobs_out) {
+    FILE *file = fopen(path, "r");
+    if (file == NULL) {
+        perror(path);
+        return -1;
+    }
+
+    struct TraceJob *jobs = NULL;
+    int count = 0, capacity = 0;
+    static char line[MAX_LINE * 2 + 64];
+    while (fgets(line, sizeof(line), file) != NULL) {
+        line[strcspn(line, "\n")] = '\0';
+        if (line[0] == '#' || line[0] == '\0') {
+            continue;
+        }
+        char *fields[5];
+        int n = 0;
+        char *cursor = line;
+        while (n < 5 && cursor != NULL) {
+            fields[n++] = cursor;
+            cursor = n < 5 ? strchr(cursor, '\t') : NULL;
+            if (cursor != NULL) {
+                *cursor++ = '\0';
+            }
+        }
+        if (n < 4) {
+            continue;
+        }
+        long long ms = atoll(fields[0]);
+        int id = atoi(fields[2]);
+
+        if (strcmp(fields[1], TRACE_SUBMIT) == 0 && n == 5) {
+            if (count == capacity) {
+                capacity = capacity ? capacity * 2 : 256;
+                struct TraceJob *grown = realloc(jobs, capacity * sizeof(*jobs));
+                if (grown == NULL) {
+                    perror("realloc");
+                    break;
+                }
+                jobs = grown;
+            }
+            struct TraceJob *job = &jobs[count++];
+            job->id = id;
+            job->submit_ms = ms;
+            job->exit_ms = -1;
+            job->code = -1;
+            job->cpu_ms = 0;
+            snprintf(job->after, sizeof(job->after), "%s", fields[3]);
+            snprintf(job->line, sizeof(job->line), "%s", fields[4]);
+        } else if (strcmp(fields[1], TRACE_EXIT) == 0 && n == 5) {
+            // Pids can be reused over a long trace: an exit belongs to the latest submission of its id
+            for (int j = count - 1; j >= 0; j--) {
+                if (jobs[j].id == id) {
+                    if (jobs[j].exit_ms == -1) {
+                        jobs[j].exit_ms = ms;
+                        jobs[j].code = atoi(fields[3]);
+                        jobs[j].cpu_ms = atoll(fields[4]);
+                    }
+                    break;
+                }
+            }
+        }
+    }
+    fclose(file);
+    *jobs_out = jobs;
+    return count;
+}
+
+// Function to order turnaround times for percentiles
+static int compare_ms(const void *a, const void *b) {
+    long long x = *(const long long *)a, y = *(const long long *)b;
+    return (x > y) - (x < y);
+}
+
+// Function to compute a trace's metrics
+static void compute_metrics(const struct TraceJob *jobs, int count, struct TraceMetrics *m) {
+    long long *turnaround = malloc((count > 0 ? count : 1) * sizeof(long long));
+    long long first = -1, last = -1;
+    double total = 0;
+
+    memset(m, 0, sizeof(*m));
+    m->submitted = count;
+    for (int j = 0; j < count; j++) {
+        if (first == -1 || jobs[j].submit_ms < first) {
+            first = jobs[j].submit_ms;
+        }
+        if (jobs[j].exit_ms == -1) {
+            continue;
+        }
+        turnaround[m->finished++] = jobs[j].exit_ms - jobs[j].submit_ms;
+        total += jobs[j].exit_ms - jobs[j].submit_ms;
+        m->failed += jobs[j].code != 0;
+        m->cpu_ms += jobs[j].cpu_ms;
+        if (jobs[j].exit_ms > last) {
+            last = jobs[j].exit_ms;
+        }
+    }
+    if (m->finished > 0) {
+        qsort(turnaround, m->finished, sizeof(long long), compare_ms);
+        m->makespan_ms = last - first;
+        m->throughput = m->makespan_ms > 0 ? m->finished * 1000.0 / m->makespan_ms : 0;
+        m->mean_turnaround = total / m->finished;
+        m->p50 = turnaround[(m->finished - 1) * 50 / 100];
+        m->p95 = turnaround[(m->finished - 1) * 95 / 100];
+        m->p99 = turnaround[(m->finished - 1) * 99 / 100];
+        m->max_turnaround = turnaround[m->finished - 1];
+    }
+    free(turnaround);
+}
+
+// Function to get the monotonic time in ms
+static long long now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+// Function to send one request and read its final reply line; returns the line's length or -1
+static int request(int fd, struct LineReader *reader, const char *text, char *reply, size_t size) {
+    size_t length = strlen(text);
+    for (size_t sent = 0; sent < length;) {
+        ssize_t n = send(fd, text + sent, length - sent, MSG_NOSIGNAL);
+        if (n == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        sent += n;
+    }
+    while (1) {
+        int ready = line_reader_next(reader, reply, size);
+        if (ready == 1) {
+            if (strncmp(reply, "ok", 2) == 0 || strncmp(reply, "error", 5) == 0) {
+                return (int)strlen(reply);
+            }
+            continue;
+        }
+        if (ready == -1 || line_reader_fill(reader) <= 0) {
+            return -1;
+        }
+    }
+}
+
+// Function to connect to a daemon's socket, waiting for it to come up; returns the socket or -1
+static int connect_daemon(const char *path, pid_t daemon) {
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    snprintf(addr.sun_path, sizeof(addr.sun_path), "%s", path);
+
+    for (int attempt = 0; attempt < 500; attempt++) {
+        int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd == -1) {
+            return -1;
+        }
+        if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) == 0) {
+            return fd;
+        }
+        close(fd);
+        if (waitpid(daemon, NULL, WNOHANG) == daemon) {
+            return -1; // It exited before listening
+        }
+        usleep(10000);
+    }
+    return -1;
+}
+
+// Function to map a recorded --after list to the new run's ids; returns -1 if a parent was not replayed
+static int map_after(const char *after, const struct TraceJob *jobs, const int *new_ids, int count,
+                     char *out, size_t size) {
+    size_t used = 0;
+    out[0] = '\0';
+    if (strcmp(after, "-") == 0) {
+        return 0;
+    }
+    for (const char *id = after; *id != '\0';) {
+        char *end;
+        int old = (int)strtol(id, &end, 10);
+        if (end == id) {
+            return -1;
+        }
+        int mapped = 0;
+        for (int j = count - 1; j >= 0; j--) {
+            if (jobs[j].id == old) {
+                mapped = new_ids[j];
+                break;
+            }
+        }
+        if (mapped <= 0) {
+            return -1;
+        }
+        int n = snprintf(out + used, size - used, "%s%d", used == 0 ? "--after " : ",", mapped);
+        if (n < 0 || (size_t)n >= size - used) {
+            return -1;
+        }
+        used += n;
+        id = *end == ',' ? end + 1 : end;
+    }
+    return 0;
+}
+
+// Function to replay a trace against one scheduler command line, recording the run to run_trace.
+// Jobs are submitted in trace order at their recorded offsets divided by speed; only jobs that were
+// recorded as submitted are replayed, and ids in --after lists are mapped to the new run's pids.
+static int replay_run(char *argv[], int argc, const struct TraceJob *jobs, int count, double speed,
+                      const char *run_trace, const char *run_output) {
+    char socket_path[108];
+    snprintf(socket_path, sizeof(socket_path), "/tmp/replay-%d.sock", (int)getpid());
+    unlink(socket_path);
+
+    char **args = calloc(argc + 7, sizeof(char *));
+    if (args == NULL) {
+        perror("calloc");
+        return -1;
+    }
+    memcpy(args, argv, argc * sizeof(char *));
+    args[argc] = "--daemon";
+    args[argc + 1] = "--socket";
+    args[argc + 2] = socket_path;
+    args[argc + 3] = "--record";
+    args[argc + 4] = (char *)run_trace;
+
+    pid_t daemon = fork();
+    if (daemon == -1) {
+        perror("fork");
+        free(args);
+        return -1;
+    }
+    if (daemon == 0) {
+        int out = open(run_output, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        int null = open("/dev/null", O_RDONLY);
+        if (out == -1 || null == -1) {
+            perror(run_output);
+            _exit(127);
+        }
+        dup2(null, STDIN_FILENO);
+        dup2(out, STDOUT_FILENO);
+        dup2(out, STDERR_FILENO);
+        execvp(args[0], args);
+        perror(args[0]);
+        _exit(127);
+    }
+    free(args);
+
+    int fd = connect_daemon(socket_path, daemon);
+    if (fd == -1) {
+        fprintf(stderr, "%s did not start a daemon; see %s\n", argv[0], run_output);
+        kill(daemon, SIGTERM);
+        waitpid(daemon, NULL, 0);
+        return -1;
+    }
+
+    static struct LineReader reader;
+    static char text[MAX_LINE * 2 + 64];
+    static char reply[MAX_LINE];
+    char after[MAX_LINE];
+    int *new_ids = calloc(count > 0 ? count : 1, sizeof(int));
+    int skipped = 0;
+    line_reader_init(&reader, fd);
+
+    long long start = now_ms();
+    long long base = count > 0 ? jobs[0].submit_ms : 0;
+    for (int j = 0; j < count; j++) {
+        // Sleep to the absolute due time, so long gaps in a trace neither wrap nor drift
+        long long due = start + (long long)((jobs[j].submit_ms - base) / speed);
+        struct timespec until = { .tv_sec = due / 1000, .tv_nsec = (due % 1000) * 1000000 };
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &until, NULL) == EINTR) {
+        }
+        if (map_after(jobs[j].after, jobs, new_ids, j, after, sizeof(after)) == -1) {
+            skipped++;
+            continue;
+        }
+        snprintf(text, sizeof(text), "submit %s%s%s\n", after, after[0] ? " " : "", jobs[j].line);
+        if (request(fd, &reader, text, reply, sizeof(reply)) == -1) {
+            fprintf(stderr, "Lost the connection to %s\n", argv[0]);
+            break;
+        }
+        if (sscanf(reply, "ok %d", &new_ids[j]) != 1) {
+            skipped++;
+        }
+    }
+    if (skipped > 0) {
+        fprintf(stderr, "%s: %d submission(s) not accepted; see %s\n", argv[0], skipped, run_output);
+    }
+
+    // Shutdown returns at once; the daemon exits when its queue has drained
+    request(fd, &reader, "shutdown\n", reply, sizeof(reply));
+    close(fd);
+    waitpid(daemon, NULL, 0);
+    free(new_ids);
+    return 0;
+}
+
+// Function to print the metrics of every run side by side
+static void print_comparison(const char *names[], const struct TraceMetrics metrics[], int runs) {
+    printf("%-22s", "");
+    for (int r = 0; r < runs; r++) {
+        printf(" %16.16s", names[r]);
+    }
+    printf("\n");
+
+#define METRIC_ROW(label, format, expr) \
+    do { \
+        printf("%-22s", label); \
+        for (int r = 0; r < runs; r++) { \
+            const struct TraceMetrics *m = &metrics[r]; \
+            printf(" %16" format, expr); \
+        } \
+        printf("\n"); \
+    } while (0)
+
+    METRIC_ROW("jobs submitted", "d", m->submitted);
+    METRIC_ROW("jobs finished", "d", m->finished);
+    METRIC_ROW("jobs failed", "d", m->failed);
+    METRIC_ROW("makespan (ms)", "lld", m->makespan_ms);
+    METRIC_ROW("throughput (jobs/s)", ".2f", m->throughput);
+    METRIC_ROW("mean turnaround (ms)", ".1f", m->mean_turnaround);
+    METRIC_ROW("p50 turnaround (ms)", "lld", m->p50);
+    METRIC_ROW("p95 turnaround (ms)", "lld", m->p95);
+    METRIC_ROW("p99 turnaround (ms)", "lld", m->p99);
+    METRIC_ROW("max turnaround (ms)", "lld", m->max_turnaround);
+    METRIC_ROW("CPU time (ms)", "lld", m->cpu_ms);
+#undef METRIC_ROW
+}
+
+// Replay driver: re-submit a recorded trace to one or more scheduler builds and compare the runs
+int main(int argc, char *argv[]) {
+    double speed = 1;
+    const char *dir = "/tmp";
+    int opt;
+
+    while ((opt = getopt(argc, argv, "+x:o:h")) != -1) {
+        if (opt == 'x') {
+            speed = atof(optarg);
+            if (speed <= 0) {
+                fprintf(stderr, "Invalid speed: %s\n", optarg);
+                return 2;
+            }
+        } else if (opt == 'o') {
+            dir = optarg;
+        } else {
+            print_usage(argv[0]);
+            return opt == 'h' ? 0 : 2;
+        }
+    }
+    if (optind >= argc || strcmp(argv[optind], "--") == 0) {
+        print_usage(argv[0]);
+        return 2;
+    }
+
+    const char *trace_path = argv[optind++];
+    struct TraceJob *jobs;
+    int count = load_trace(trace_path, &jobs);
+    if (count == -1) {
+        return 2;
+    }
+
+    const char *names[MAX_RUNS + 1] = { "trace" };
+    struct TraceMetrics metrics[MAX_RUNS + 1];
+    static char run_traces[MAX_RUNS][PATH_MAX];
+    int runs = 1;
+    compute_metrics(jobs, count, &metrics[0]);
+
+    // Each "--" starts another scheduler command line
+    while (optind < argc && runs <= MAX_RUNS) {
+        if (strcmp(argv[optind], "--") != 0) {
+            fprintf(stderr, "Expected -- before a scheduler command: %s\n", argv[optind]);
+            return 2;
+        }
+        int first = ++optind;
+        while (optind < argc && strcmp(argv[optind], "--") != 0) {
+            optind++;
+        }
+        if (optind == first) {
+            print_usage(argv[0]);
+            return 2;
+        }
+
+        char *run_trace = run_traces[runs - 1];
+        char run_output[PATH_MAX];
+        snprintf(run_trace, PATH_MAX, "%s/replay-%d.trace", dir, runs);
+        snprintf(run_output, sizeof(run_output), "%s/replay-%d.out", dir, runs);
+        printf("Run %d: %s (%d job(s) at %gx)\n", runs, argv[first], count, speed);
+        fflush(stdout);
+        if (replay_run(argv + first, optind - first, jobs, count, speed, run_trace, run_output) == -1) {
+            return 1;
+        }
+
+        struct TraceJob *run_jobs;
+        int run_count = load_trace(run_trace, &run_jobs);
+        if (run_count == -1) {
+            return 1;
+        }
+        compute_metrics(run_jobs, run_count, &metrics[runs]);
+        free(run_jobs);
+        const char *name = strrchr(argv[first], '/');
+        names[runs++] = name != NULL ? name + 1 : argv[first];
+    }
+
+    print_comparison(names, metrics, runs);
+    for (int r = 1; r < runs; r++) {
+        printf("Run %d trace: %s\n", r, run_traces[r - 1]);
+    }
+    free(jobs);
+    return 0;
+}
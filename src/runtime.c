@@ -0,0 +1,214 @@
+#include "../include/scheduler.h"
+#include "../include/globals.h"
+#include <math.h>
+
+#define RUNTIME_DB_HEADER "# shell-scheduler runtime model v1"
+
+// The runtime model keeps an exponentially weighted mean and variance of the CPU time of successful
+// runs, per command line (program and argument hash) and per program. It lives in the shared queue,
+// so the front-end records completions and the scheduler reads predictions, and it can be saved to
+// a file so that repeated workloads are predicted from their first submission.
+
+// Function to hash a command's argument vector (FNV-1a); never returns 0, which marks program entries
+uint64_t command_hash(const struct Command *cmd) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (int i = 0; i < cmd->argc; i++) {
+        for (const char *c = cmd->argv[i]; *c != '\0'; c++) {
+            hash = (hash ^ (unsigned char)*c) * 1099511628211ULL;
+        }
+        hash = (hash ^ 0xff) * 1099511628211ULL; // Separator, so "ab c" and "a bc" differ
+    }
+    return hash != 0 ? hash : 1;
+}
+
+// Function to find a model entry; returns NULL if there is none
+static struct RuntimeStat *find_runtime(const char *program, uint64_t hash) {
+    for (int r = 0; r < scheduler_queue->runtime_count; r++) {
+        struct RuntimeStat *stat = &scheduler_queue->runtimes[r];
+        if (stat->command_hash == hash && strcmp(stat->program, program) == 0) {
+            return stat;
+        }
+    }
+    return NULL;
+}
+
+// Function to add a model entry, evicting the least recently updated one if the table is full
+static struct RuntimeStat *add_runtime(const char *program, uint64_t hash) {
+    struct RuntimeStat *stat;
+    if (scheduler_queue->runtime_count < MAX_RUNTIME_STATS) {
+        stat = &scheduler_queue->runtimes[scheduler_queue->runtime_count++];
+    } else {
+        stat = &scheduler_queue->runtimes[0];
+        for (int r = 1; r < MAX_RUNTIME_STATS; r++) {
+            if (scheduler_queue->runtimes[r].last_used < stat->last_used) {
+                stat = &scheduler_queue->runtimes[r];
+            }
+        }
+    }
+    memset(stat, 0, sizeof(*stat));
+    strncpy(stat->program, program, MAX_PROGRAM_KEY - 1);
+    stat->command_hash = hash;
+    return stat;
+}
+
+// Function to fold one run into an entry; recent runs count most
+static void update_runtime(struct RuntimeStat *stat, double ms) {
+    if (stat->samples == 0) {
+        stat->mean = ms;
+        stat->variance = 0;
+    } else {
+        double diff = ms - stat->mean;
+        stat->mean += diff / 4;
+        stat->variance = 0.75 * (stat->variance + diff * diff / 4);
+    }
+    stat->samples++;
+    stat->last_used = scheduler_queue->tick;
+}
+
+// Function to record the run time of a job that succeeded; call with the queue lock held
+void record_runtime(const struct Process *process) {
+    const uint64_t hashes[2] = { process->command_hash, 0 };
+    for (int h = 0; h < 2; h++) {
+        if (h == 0 && hashes[h] == 0) {
+            continue; // Coordinator jobs carry no argument hash
+        }
+        struct RuntimeStat *stat = find_runtime(process->program, hashes[h]);
+        if (stat == NULL) {
+            stat = add_runtime(process->program, hashes[h]);
+        }
+        update_runtime(stat, process->total_execution_time);
+    }
+}
+
+// Function to predict a process's total run time in ms from the same command line, or failing that
+// the same program; returns -1 if neither has run yet. stddev, if not NULL, receives the spread.
+double predicted_runtime(const struct Process *process, double *stddev) {
+    struct RuntimeStat *stat = find_runtime(process->program, process->command_hash);
+    if (stat == NULL || process->command_hash == 0) {
+        stat = find_runtime(process->program, 0);
+    }
+    if (stat == NULL) {
+        return -1;
+    }
+    if (stddev != NULL) {
+        *stddev = sqrt(stat->variance);
+    }
+    return stat->mean;
+}
+
+// Function to estimate how much longer a process will run, in ms: what the job last reported through
+// progress.h, else its predicted run time less the CPU time it has used
+long long remaining_estimate(const struct Process *process) {
+    long long reported = reported_remaining_ms(process->progress_slot);
+    if (reported >= 0) {
+        return reported > 1 ? reported : 1;
+    }
+    double predicted = predicted_runtime(process, NULL);
+    long long estimate = predicted >= 0 ? (long long)predicted : TSLICE; // Unknown: assume one slice
+    estimate -= process->total_execution_time;
+    return estimate > 1 ? estimate : 1;
+}
+
+// Function to estimate a process's whole run time in ms for shortest-job-first ordering; programs
+// never seen are assumed to need one slice, so they run early and get measured
+long long total_estimate(const struct Process *process) {
+    double predicted = predicted_runtime(process, NULL);
+    return predicted >= 0 ? (long long)predicted : TSLICE;
+}
+
+// Function to size the quantum of a job that is starting, in ms, or 0 to stop it with the round.
+// Under sjf and srpt a job that is confidently expected to finish within two slices (its mean plus two
+// standard deviations, or its own report) is left running until then instead of being stopped just
+// short of completion.
+long long job_quantum(const struct Process *process) {
+    if (sched_config.policy != POLICY_SJF && sched_config.policy != POLICY_SRPT) {
+        return 0;
+    }
+    long long upper = reported_remaining_ms(process->progress_slot);
+    if (upper < 0) {
+        double stddev;
+        double predicted = predicted_runtime(process, &stddev);
+        if (predicted < 0) {
+            return 0;
+        }
+        upper = (long long)(predicted + 2 * stddev) - process->total_execution_time;
+    }
+    if (upper <= TSLICE || upper > 2 * TSLICE) {
+        return 0;
+    }
+    return upper + SAMPLE_INTERVAL_MS;
+}
+
+// Function to load a saved runtime model into the queue before the scheduler starts
+int load_runtime_model(const char *path) {
+    FILE *file = fopen(path, "r");
+    if (file == NULL) {
+        if (errno == ENOENT) {
+            return 0; // First run: nothing saved yet
+        }
+        perror(path);
+        return -1;
+    }
+
+    char line[MAX_PROGRAM_KEY + 128];
+    int loaded = 0;
+    while (fgets(line, sizeof(line), file) != NULL) {
+        char program[MAX_PROGRAM_KEY];
+        unsigned long long hash;
+        int samples;
+        double mean, variance;
+        if (line[0] == '#' ||
+            sscanf(line, "%63[^\t]\t%llx\t%d\t%lf\t%lf", program, &hash, &samples, &mean, &variance) != 5 ||
+            samples <= 0 || mean < 0 || variance < 0 || find_runtime(program, hash) != NULL) {
+            continue;
+        }
+        if (scheduler_queue->runtime_count == MAX_RUNTIME_STATS) {
+            break;
+        }
+        struct RuntimeStat *stat = add_runtime(program, hash);
+        stat->samples = samples;
+        stat->mean = mean;
+        stat->variance = variance;
+        loaded++;
+    }
+    fclose(file);
+    return loaded;
+}
+
+// Function to save the runtime model; the file is replaced atomically so a crash never truncates it
+int save_runtime_model(const char *path) {
+    char temp[PATH_MAX + 8];
+    snprintf(temp, sizeof(temp), "%s.tmp", path);
+    FILE *file = fopen(temp, "w");
+    if (file == NULL) {
+        perror(temp);
+        return -1;
+    }
+
+    // Most recently updated first, so a smaller table reloads the entries that matter
+    static char saved[MAX_RUNTIME_STATS];
+    memset(saved, 0, sizeof(saved));
+    fprintf(file, "%s\n", RUNTIME_DB_HEADER);
+    for (int n = 0; n < scheduler_queue->runtime_count; n++) {
+        int newest = -1;
+        for (int r = 0; r < scheduler_queue->runtime_count; r++) {
+            if (!saved[r] && (newest == -1 ||
+                              scheduler_queue->runtimes[r].last_used > scheduler_queue->runtimes[newest].last_used)) {
+                newest = r;
+            }
+        }
+        struct RuntimeStat *stat = &scheduler_queue->runtimes[newest];
+        saved[newest] = 1;
+        if (strpbrk(stat->program, "\t\n") != NULL) {
+            continue; // Cannot be written as one line
+        }
+        fprintf(file, "%s\t%llx\t%d\t%.1f\t%.1f\n", stat->program, (unsigned long long)stat->command_hash,
+                stat->samples, stat->mean, stat->variance);
+    }
+    if (fclose(file) != 0 || rename(temp, path) == -1) {
+        perror(path);
+        unlink(temp);
+        return -1;
+    }
+    return 0;
+}
@@ -1,13 +1,89 @@
 #include "../include/scheduler.h"
 #include "../include/globals.h"
+#include "../include/policy.h"
+#include <ctype.h>
+#include <stdarg.h>
+#include <poll.h>
+
+// Function to set or clear one queue position in a state mask
+static void mask_assign(uint64_t mask[], int i, int on) {
+    uint64_t bit = 1ULL << (i % 64);
+    if (on) {
+        mask[i / 64] |= bit;
+    } else {
+        mask[i / 64] &= ~bit;
+    }
+}
+
+// Function to drop queue position i from a state mask, moving the positions above it down by one
+static void mask_remove(uint64_t mask[], int i) {
+    int w = i / 64, b = i % 64;
+    uint64_t below = mask[w] & ((1ULL << b) - 1);
+    uint64_t above = b == 63 ? 0 : (mask[w] >> (b + 1)) << b;
+    mask[w] = below | above;
+    for (; w + 1 < QUEUE_MASK_WORDS; w++) {
+        mask[w] |= (mask[w + 1] & 1) << 63;
+        mask[w + 1] >>= 1;
+    }
+}
+
+// Function to find the first position at or after from whose bit is set in a state mask, or -1
+int next_in_mask(const uint64_t mask[], int from) {
+    int w = from / 64;
+    if (w >= QUEUE_MASK_WORDS) {
+        return -1;
+    }
+    uint64_t bits = mask[w] & (~0ULL << (from % 64));
+    while (bits == 0) {
+        if (++w == QUEUE_MASK_WORDS) {
+            return -1;
+        }
+        bits = mask[w];
+    }
+    return w * 64 + __builtin_ctzll(bits);
+}
+
+// Function to count the positions set in a state mask
+int count_in_mask(const uint64_t mask[]) {
+    int count = 0;
+    for (int w = 0; w < QUEUE_MASK_WORDS; w++) {
+        count += __builtin_popcountll(mask[w]);
+    }
+    return count;
+}
+
+// Function to change the state of the process at queue position i; call with the queue lock held
+void set_process_state(int i, int state) {
+    scheduler_queue->processes[i].state = state;
+    mask_assign(scheduler_queue->waiting_mask, i, state == 1);
+    mask_assign(scheduler_queue->running_mask, i, state == 0);
+    mask_assign(scheduler_queue->blocked_mask, i, state == 2);
+}
+
+// Function to find the queue position of a process by pid, or -1; call with the queue lock held
+int find_process(pid_t pid) {
+    for (int i = 0; i <= scheduler_queue->rear; i++) {
+        if (scheduler_queue->pids[i] == pid) {
+            return i;
+        }
+    }
+    return -1;
+}
 
 // Function to enqueue a process in the queue
-void enqueue(struct ProcessQueue* queue, struct Process process) {
+int enqueue(struct ProcessQueue* queue, struct Process process) {
     if (queue->rear == MAX_PROCESSES - 1) {
         printf("Queue is full.\n");
-        return;
+        return -1;
     }
+    queue->rear++;
     queue->processes[queue->rear] = process;
+    queue->pids[queue->rear] = process.pid;
+    set_process_state(queue->rear, process.state);
+    if (process.after_count > 0) {
+        queue->dependent_jobs++;
+    }
+    return 0;
 }
 
 // Signal handler for SIGUSR1 - Used to wake up the scheduler
@@ -16,12 +92,119 @@ void handleSIGUSR1(int signo) {
     sem_post(&scheduler_sem);
 }
 
+// Function to read the monotonic clock in milliseconds
+long long monotonic_ms(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (long long)now.tv_sec * 1000 + now.tv_nsec / 1000000;
+}
+
+// Function to print one terminated process record
+static void print_terminated_process(const struct Process *process) {
+    printf("Terminated %s %d. Execution Time: %lld ms and %lld ms waiting time", 
+           process->in_process ? "Task with ID" : "Process with PID", process->pid,
+           process->total_execution_time, process->waiting_time);
+    if (process->deadline != 0) {
+        long long slack = process->deadline - process->finish_time;
+        if (slack >= 0) {
+            printf(", deadline met with %lld ms to spare", slack);
+        } else {
+            printf(", deadline MISSED by %lld ms", -slack);
+        }
+    }
+    if (process->failed_parent != 0) {
+        printf(", cancelled: dependency %d did not succeed", (int)process->failed_parent);
+    }
+    print_job_counters(process);
+    printf("\n");
+}
+
 // Function to print the terminated process queue
 void printTerminatedQueue(struct TerminatedQueue* queue) {
-    for (int i = 0; i <= queue->rear; i++) {
-        printf("Terminated Process with PID %d. Execution Time: %lld ms and %lld ms waiting time\n", 
-               queue->processes[i].pid, queue->processes[i].total_execution_time, queue->processes[i].waiting_time);
+    int first = queue->rear - MAX_PROCESSES + 1;
+    for (int i = first > 0 ? first : 0; i <= queue->rear; i++) {
+        print_terminated_process(&queue->processes[i % MAX_PROCESSES]);
+    }
+    print_tenant_usage();
+    print_deadline_summary();
+    print_memory_summary();
+    print_dispatch_summary();
+    print_counter_summary();
+    print_task_summary();
+}
+
+// Function to print terminated processes not yet printed; cursor counts records already seen
+void drain_terminated_queue(int *cursor) {
+    int rear = terminated_queue->rear;
+    if (rear - *cursor >= MAX_PROCESSES) {
+        int lost = rear - *cursor - MAX_PROCESSES + 1;
+        printf("%d terminated process record(s) were overwritten before being printed\n", lost);
+        *cursor += lost;
+    }
+    for (; *cursor <= rear; (*cursor)++) {
+        print_terminated_process(&terminated_queue->processes[*cursor % MAX_PROCESSES]);
     }
+    terminated_queue->reported = *cursor;
+    task_records_drained();
+}
+
+// Function to move a finished process to the terminated queue; call with the queue lock held.
+// cpu_ms is the CPU time the job really used, not the slices it was given (the larger of it and what
+// was already charged to its process group is kept); status is its wait
+// status, or -1 if it was lost or cancelled. Jobs depending on it are released or cancelled.
+void retire_process(int i, long long cpu_ms, int status) {
+    struct Process *process = &scheduler_queue->processes[i];
+    set_process_state(i, -1);
+    process->exit_status = process->failed_parent != 0 ? -1 : status; // Killed by us, not failed on its own
+    release_progress_slot(process->progress_slot);
+    gettimeofday(&process->end_time, NULL);
+    if (process->start_time.tv_sec != 0) { // Cancelled jobs may never have run
+        struct timeval elapsedTime;
+        elapsedTime.tv_sec = process->end_time.tv_sec - process->start_time.tv_sec;
+        elapsedTime.tv_usec = process->end_time.tv_usec - process->start_time.tv_usec;
+        long long elapsed = elapsedTime.tv_sec * 1000 + elapsedTime.tv_usec / 1000;
+        process->waiting_time += elapsed;
+    }
+
+    if (cpu_ms > process->total_execution_time) {
+        scheduler_queue->tenants[process->tenant].usage += cpu_ms - process->total_execution_time;
+        process->total_execution_time = cpu_ms;
+    }
+    process->finish_time = monotonic_ms();
+    if (process->deadline != 0) {
+        scheduler_queue->deadline_jobs++;
+        if (process->finish_time > process->deadline) {
+            scheduler_queue->deadline_misses++;
+        }
+    }
+    if (status != -1 && WIFEXITED(status) && WEXITSTATUS(status) == 0) {
+        record_runtime(process);
+    }
+    for (int k = 0; k < COUNTER_KINDS; k++) {
+        scheduler_queue->counter_totals[k] += process->counters[k];
+    }
+    trace_exit(process);
+
+    // Move the process to the terminated queue
+    terminated_queue->rear++;
+    terminated_queue->processes[terminated_queue->rear % MAX_PROCESSES] = *process;
+    record_outcome(process);
+
+    // Remove the process from the scheduling queue
+    if (process->after_count > 0) {
+        scheduler_queue->dependent_jobs--;
+    }
+    for (int j = i; j < scheduler_queue->rear; j++) {
+        scheduler_queue->processes[j] = scheduler_queue->processes[j + 1];
+        scheduler_queue->pids[j] = scheduler_queue->pids[j + 1];
+    }
+    mask_remove(scheduler_queue->waiting_mask, i);
+    mask_remove(scheduler_queue->running_mask, i);
+    mask_remove(scheduler_queue->blocked_mask, i);
+    scheduler_queue->rear--;
+    struct Process *record = &terminated_queue->processes[terminated_queue->rear % MAX_PROCESSES];
+    release_dependents(record);
+    policy_on_exit(record);
 }
 
 // Signal handler for child process completion
@@ -29,34 +212,472 @@ void handleSIGCHLD(int signo) {
     (void)signo; // Suppress unused parameter warning
     int status;
     pid_t pid;
+    struct rusage usage;
 
-    while ((pid = waitpid(-1, &status, WNOHANG)) > 0) {
-        sem_wait(&scheduler_queue_sem);
+    while ((pid = wait4(-1, &status, WNOHANG, &usage)) > 0) {
+        while (sem_wait(&scheduler_queue->lock) == -1 && errno == EINTR) {
+        }
 
         // Find the process in the scheduling queue
-        for (int i = 0; i <= scheduler_queue->rear; i++) {
-            if (scheduler_queue->processes[i].pid == pid) {
-                scheduler_queue->processes[i].state = -1;
-                gettimeofday(&scheduler_queue->processes[i].end_time, NULL);
-                struct timeval elapsedTime;
-                elapsedTime.tv_sec = scheduler_queue->processes[i].end_time.tv_sec - scheduler_queue->processes[i].start_time.tv_sec;
-                elapsedTime.tv_usec = scheduler_queue->processes[i].end_time.tv_usec - scheduler_queue->processes[i].start_time.tv_usec;
-                long long elapsed = elapsedTime.tv_sec * 1000 + elapsedTime.tv_usec / 1000;
-                scheduler_queue->processes[i].total_execution_time += elapsed;
-                scheduler_queue->processes[i].waiting_time += elapsed;
-                
-                // Move the process to the terminated queue
-                terminated_queue->rear++;
-                terminated_queue->processes[terminated_queue->rear] = scheduler_queue->processes[i];
-                
-                // Remove the process from the scheduling queue
-                for (int j = i; j < scheduler_queue->rear; j++) {
-                    scheduler_queue->processes[j] = scheduler_queue->processes[j + 1];
+        int i = find_process(pid);
+        if (i != -1) {
+            retire_process(i, (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000LL +
+                              (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1000, status);
+            killpg(pid, SIGKILL); // The job is over; stragglers it left in its group go with it
+        }
+        publish_snapshot(status_snapshot, scheduler_queue, scheduler_queue->slots, terminated_queue->rear + 1);
+        sem_post(&scheduler_queue->lock);
+    }
+}
+
+static sigset_t lock_saved_mask;
+
+// Function to take the scheduler queue lock; SIGCHLD stays blocked so the reaper cannot deadlock on it
+void lock_scheduler_queue(void) {
+    sigset_t block;
+    sigemptyset(&block);
+    sigaddset(&block, SIGCHLD);
+    sigprocmask(SIG_BLOCK, &block, &lock_saved_mask);
+    while (sem_wait(&scheduler_queue->lock) == -1 && errno == EINTR) {
+    }
+}
+
+// Function to release the scheduler queue lock, publishing what changed under it to status readers
+void unlock_scheduler_queue(void) {
+    publish_snapshot(status_snapshot, scheduler_queue, scheduler_queue->slots, terminated_queue->rear + 1);
+    sem_post(&scheduler_queue->lock);
+    sigprocmask(SIG_SETMASK, &lock_saved_mask, NULL);
+}
+
+#define SUBMIT_USAGE "Usage: submit [-p priority] [-g group] [--deadline ms --budget ms] [--after id,...] " \
+                     "[--dir path] <program> [args...] or submit [-g group] --lib file.so:entry [args...]"
+
+// Function to write why a job spec was refused into the caller's buffer; returns -1 for parse_job_spec
+static int spec_error(char error[MAX_SPEC_ERROR], const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    vsnprintf(error, MAX_SPEC_ERROR, format, args);
+    va_end(args);
+    return -1;
+}
+
+// Function to parse "[-p priority] [-g group] [--deadline ms --budget ms] [--after id,...] [--dir path]
+// <program> [args...]" or "[-g group] --lib file.so:entry [args...]" as given to submit. Returns -1 with
+// the reason in error if the spec is refused.
+int parse_job_spec(const char *line, struct JobSpec *spec, int legacy_priority, char error[MAX_SPEC_ERROR]) {
+    struct Command *cmd = &spec->cmd;
+
+    while (isspace((unsigned char)*line)) {
+        line++;
+    }
+    strncpy(spec->text, line, MAX_PROGRAM_NAME - 1);
+    spec->text[MAX_PROGRAM_NAME - 1] = '\0';
+    spec->priority = 1; // Default priority is 1
+    snprintf(spec->tenant, MAX_TENANT_NAME, "uid:%d", (int)getuid());
+    spec->deadline = 0;
+    spec->budget = 0;
+    spec->after_count = 0;
+    spec->lib[0] = '\0';
+    spec->dir[0] = '\0';
+
+    if (parse_command(line, cmd) <= 0) {
+        return spec_error(error, SUBMIT_USAGE);
+    }
+
+    // Scheduling options come before the program name
+    while (cmd->argc > 0 && cmd->argv[0][0] == '-') {
+        if (strcmp(cmd->argv[0], "-p") == 0 || strcmp(cmd->argv[0], "--priority") == 0) {
+            if (cmd->argc < 2) {
+                return spec_error(error, "Missing value for %s", cmd->argv[0]);
+            }
+            spec->priority = atoi(cmd->argv[1]);
+            if (spec->priority < 1 || spec->priority > 4) {
+                return spec_error(error, "Invalid priority. Priority must be between 1 and 4.");
+            }
+        } else if (strcmp(cmd->argv[0], "-g") == 0 || strcmp(cmd->argv[0], "--group") == 0) {
+            if (cmd->argc < 2) {
+                return spec_error(error, "Missing value for %s", cmd->argv[0]);
+            }
+            if (cmd->argv[1][0] == '\0' || strlen(cmd->argv[1]) >= MAX_TENANT_NAME) {
+                return spec_error(error, "Invalid group name. Groups are 1-%d characters.",
+                                  MAX_TENANT_NAME - 1);
+            }
+            strcpy(spec->tenant, cmd->argv[1]);
+        } else if (strcmp(cmd->argv[0], "--deadline") == 0 || strcmp(cmd->argv[0], "--budget") == 0) {
+            if (cmd->argc < 2) {
+                return spec_error(error, "Missing value for %s", cmd->argv[0]);
+            }
+            char *end;
+            long long ms = strtoll(cmd->argv[1], &end, 10);
+            if (*end != '\0' || ms <= 0) {
+                return spec_error(error, "Invalid %s. It must be a positive number of milliseconds.",
+                                  cmd->argv[0]);
+            }
+            if (cmd->argv[0][2] == 'd') {
+                spec->deadline = ms;
+            } else {
+                spec->budget = ms;
+            }
+        } else if (strcmp(cmd->argv[0], "--after") == 0) {
+            if (cmd->argc < 2) {
+                return spec_error(error, "Missing value for %s", cmd->argv[0]);
+            }
+            const char *id = cmd->argv[1];
+            while (*id != '\0') {
+                char *end;
+                long parent = strtol(id, &end, 10);
+                if (end == id || parent <= 0 || (*end != ',' && *end != '\0')) {
+                    return spec_error(error, "Invalid --after list. Expected job ids separated by commas.");
+                }
+                if (spec->after_count == MAX_DEPENDENCIES) {
+                    return spec_error(error, "Too many dependencies (maximum %d).", MAX_DEPENDENCIES);
+                }
+                spec->after[spec->after_count++] = (pid_t)parent;
+                id = *end == ',' ? end + 1 : end;
+            }
+        } else if (strcmp(cmd->argv[0], "--lib") == 0) {
+            if (cmd->argc < 2) {
+                return spec_error(error, "Missing value for %s", cmd->argv[0]);
+            }
+            const char *colon = strrchr(cmd->argv[1], ':');
+            if (colon == NULL || colon == cmd->argv[1] || colon[1] == '\0' ||
+                strlen(cmd->argv[1]) >= MAX_PROGRAM_NAME) {
+                return spec_error(error, "Invalid --lib. Expected file.so:entry.");
+            }
+            strcpy(spec->lib, cmd->argv[1]);
+        } else if (strcmp(cmd->argv[0], "--dir") == 0) {
+            if (cmd->argc < 2) {
+                return spec_error(error, "Missing value for %s", cmd->argv[0]);
+            }
+            if (cmd->argv[1][0] != '/' || strlen(cmd->argv[1]) >= MAX_PROGRAM_NAME) {
+                return spec_error(error, "Invalid --dir. It must be an absolute path shorter than %d characters.",
+                                  MAX_PROGRAM_NAME);
+            }
+            strcpy(spec->dir, cmd->argv[1]);
+        } else {
+            return spec_error(error, "Unknown submit option: %s", cmd->argv[0]);
+        }
+        memmove(cmd->argv, cmd->argv + 2, (cmd->argc - 1) * sizeof(char *));
+        cmd->argc -= 2;
+    }
+    if (spec->lib[0] != '\0') {
+        // Everything after the entry point is the task's arguments
+        if (spec->deadline != 0 || spec->budget != 0 || spec->after_count > 0 || spec->dir[0] != '\0') {
+            return spec_error(error, "--deadline, --budget, --after and --dir do not apply to --lib tasks.");
+        }
+        return 0;
+    }
+    if (cmd->argc == 0) {
+        return spec_error(error, SUBMIT_USAGE);
+    }
+    if (spec->dir[0] != '\0') {
+        cmd->dir = spec->dir;
+    }
+    if ((spec->deadline != 0) != (spec->budget != 0)) {
+        return spec_error(error, "--deadline and --budget must be given together.");
+    }
+    if (spec->budget > spec->deadline) {
+        return spec_error(error, "A budget of %lld ms can never be met within a %lld ms deadline.",
+                          spec->budget, spec->deadline);
+    }
+
+    // Keep accepting the original "submit <program> <priority>" form
+    if (legacy_priority && cmd->argc == 2 && cmd->argv[1][1] == '\0' &&
+        cmd->argv[1][0] >= '1' && cmd->argv[1][0] <= '4') {
+        spec->priority = cmd->argv[1][0] - '0';
+        cmd->argv[1] = NULL;
+        cmd->argc = 1;
+    }
+    return 0;
+}
+
+// Function to launch a batch of jobs stopped and hand them to the scheduler with one wake-up.
+// --lib specs go to the in-process worker pool instead and take no room in the queue.
+// Returns how many specs were consumed; if ids is not NULL it receives each consumed job's pid
+// (task id for --lib), or 0 for a job that could not be started or was rejected.
+int queue_jobs(struct JobSpec *specs, int count, pid_t scheduler_pid, pid_t ids[]) {
+    static struct Process batch[MAX_PROCESSES];
+    static const char *tenants[MAX_PROCESSES];
+    static int spec_index[MAX_PROCESSES];
+    int room = MAX_PROCESSES - 1 - scheduler_queue->rear;
+    int started = 0;
+
+    // Consume specs up to the first process the queue has no room for
+    for (int i = 0, processes = 0; i < count; i++) {
+        if (specs[i].lib[0] == '\0' && processes++ == room) {
+            count = i;
+        }
+    }
+    for (int i = 0; ids != NULL && i < count; i++) {
+        ids[i] = 0;
+    }
+
+    // Fork the whole batch first so the children park themselves in parallel
+    for (int i = 0; i < count; i++) {
+        struct Process *new_process = &batch[started];
+        if (specs[i].lib[0] != '\0') {
+            continue;
+        }
+        memset(new_process, 0, sizeof(*new_process));
+        new_process->node = -1;
+        new_process->progress_slot = -1;
+
+        if (sched_config.listen[0] != '\0') {
+            // Coordinator mode: a node agent launches the job when it is first dispatched
+            if (format_command(&specs[i].cmd, new_process->command, sizeof(new_process->command)) == -1) {
+                printf("Command too long to send to a node: %s\n", specs[i].text);
+                continue;
+            }
+        } else {
+            pid_t child_pid;
+            if (job_logs_enabled()) {
+                int output;
+                child_pid = spawn_captured(&specs[i].cmd, SPAWN_STOPPED | SPAWN_NOWAIT | SPAWN_PGROUP, &output);
+                if (child_pid != -1) {
+                    watch_job_output(child_pid, output);
                 }
-                scheduler_queue->rear--;
+            } else {
+                child_pid = spawn_command(&specs[i].cmd, SPAWN_STOPPED | SPAWN_NOWAIT | SPAWN_PGROUP);
+            }
+            if (child_pid == -1) {
+                continue;
+            }
+            new_process->pid = child_pid;
+            strcpy(new_process->command, specs[i].text);
+        }
+
+        spec_index[started] = i;
+        tenants[started++] = specs[i].tenant;
+        new_process->priority = specs[i].priority;
+        new_process->state = 1;
+        new_process->total_execution_time = 0;
+        new_process->waiting_time = TSLICE;
+        new_process->budget = specs[i].budget;
+        const char *program = strrchr(specs[i].cmd.argv[0], '/');
+        program = program != NULL ? program + 1 : specs[i].cmd.argv[0];
+        strncpy(new_process->program, program, MAX_PROGRAM_KEY - 1);
+        new_process->command_hash = command_hash(&specs[i].cmd);
+        if (specs[i].deadline != 0) {
+            new_process->deadline = monotonic_ms() + specs[i].deadline;
+        }
+    }
+    // Only children that parked themselves are queued; one that died first has no process left to run
+    int parked = 0;
+    for (int i = 0; i < started; i++) {
+        if (sched_config.listen[0] == '\0' && !wait_for_stop(batch[i].pid)) {
+            printf("Exited before it could be queued: %s\n", batch[i].command);
+            continue;
+        }
+        batch[parked] = batch[i];
+        tenants[parked] = tenants[i];
+        spec_index[parked++] = spec_index[i];
+    }
+    started = parked;
+
+    // Libraries are loaded and the worker pool started before taking the lock
+    for (int i = 0; i < count; i++) {
+        if (specs[i].lib[0] != '\0') {
+            specs[i].task_library = prepare_task(&specs[i]);
+        }
+    }
+
+    lock_scheduler_queue();
+    for (int i = 0; i < started; i++) {
+        int remote = sched_config.listen[0] != '\0';
+        const struct JobSpec *spec = &specs[spec_index[i]];
+        batch[i].seq = ++scheduler_queue->last_seq;
+        int admitted = resolve_dependencies(&batch[i], spec->after, spec->after_count) == 0;
+        if (admitted && !policy_enqueue(&batch[i], monotonic_ms())) {
+            printf("Rejected by admission control (deadline set would be infeasible): %s\n", batch[i].command);
+            admitted = 0;
+        }
+        if (!admitted) {
+            if (!remote) {
+                killpg(batch[i].pid, SIGKILL);
+            }
+            continue;
+        }
+        if (remote) {
+            batch[i].pid = ++scheduler_queue->last_job_id; // Job ids stand in for pids across nodes
+        }
+        batch[i].tenant = intern_tenant(tenants[i]);
+        scheduler_queue->tenants[batch[i].tenant].processes++;
+        if (!remote) {
+            batch[i].progress_slot = claim_progress_slot(batch[i].pid);
+        }
+        if (enqueue(scheduler_queue, batch[i]) == -1) {
+            if (!remote) {
+                release_progress_slot(batch[i].progress_slot);
+                killpg(batch[i].pid, SIGKILL);
+            }
+            continue;
+        }
+        if (ids != NULL) {
+            ids[spec_index[i]] = batch[i].pid;
+        }
+        trace_submit(&specs[spec_index[i]], batch[i].pid);
+    }
+    for (int i = 0; i < count; i++) {
+        if (specs[i].lib[0] == '\0') {
+            continue;
+        }
+        pid_t id = submit_task(&specs[i]);
+        if (id != 0) {
+            if (ids != NULL) {
+                ids[i] = id;
+            }
+            trace_submit(&specs[i], id);
+        }
+    }
+    unlock_scheduler_queue();
+
+    // Send SIGUSR1 to the scheduler
+    if (started > 0 && kill(scheduler_pid, SIGUSR1) == -1) {
+        perror("kill (SIGUSR1)");
+    }
+    return count;
+}
+
+// Function to submit one job typed at the prompt
+static void submit_job(const char *args, pid_t scheduler_pid, int legacy_priority) {
+    static struct JobSpec spec;
+    char error[MAX_SPEC_ERROR];
+
+    if (parse_job_spec(args, &spec, legacy_priority, error) == -1) {
+        printf("%s\n", error);
+        return;
+    }
+    if (queue_jobs(&spec, 1, scheduler_pid, NULL) == 0) {
+        printf("Scheduler queue is full. Cannot submit more processes.\n");
+    }
+}
+
+// Function to change the priority of a submitted job: "priority <pid> <level>"
+static void change_priority(const char *args) {
+    int pid, level;
+    char extra;
+
+    if (sscanf(args, "%d %d %c", &pid, &level, &extra) != 2) {
+        printf("Usage: priority <pid> <level>\n");
+        return;
+    }
+    if (level < 1 || level > 4) {
+        printf("Invalid priority. Priority must be between 1 and 4.\n");
+        return;
+    }
+    int result = reprioritise_job(pid, level);
+    if (result == -1) {
+        printf("No submitted process with PID %d\n", pid);
+    } else if (result == -2) {
+        printf("Priority of PID %d left unchanged: the kernel refused level %d (%s)%s\n", pid, level,
+               strerror(errno), errno == EPERM ? "; raising a priority needs CAP_SYS_NICE" : "");
+    }
+}
+
+// Function to show or change the slot count: "slots [N|auto]"
+static void change_slots(const char *args) {
+    int slots = slot_request(args);
+    if (slots == -1) {
+        printf("Usage: slots [N|auto] (N between 1 and %d)\n", MAX_PROCESSES);
+    } else {
+        printf("Slots: %d\n", slots);
+    }
+}
+
+// Function to run any other command line in the foreground with the shell's launcher
+static void run_foreground(const char *line) {
+    struct Pipeline pipeline;
+    pid_t pids[MAX_PIPELINE];
+
+    if (parse_pipeline(line, &pipeline) <= 0) {
+        return;
+    }
+
+    // Keep the SIGCHLD reaper away from our own children until they are waited for
+    sigset_t block, old;
+    sigemptyset(&block);
+    sigaddset(&block, SIGCHLD);
+    sigprocmask(SIG_BLOCK, &block, &old);
+
+    int started = spawn_pipeline(&pipeline, pids, 0);
+    for (int i = 0; i < started; i++) {
+        while (waitpid(pids[i], NULL, 0) == -1 && errno == EINTR) {
+        }
+    }
+    sigprocmask(SIG_SETMASK, &old, NULL);
+}
+
+// Shell front-end shared by both schedulers; returns when the user types exit or input ends
+void run_scheduler_shell(pid_t scheduler_pid, int legacy_priority) {
+    static struct LineReader reader;
+    char line[MAX_LINE];
+    int show_prompt = 1;
+
+    line_reader_init(&reader, STDIN_FILENO);
+    while (1) {
+        int ready = line_reader_next(&reader, line, sizeof(line));
+        if (ready == -1) {
+            break; // End of input behaves like exit
+        }
+        if (ready == 1) {
+            char *cmd = line;
+            while (isspace((unsigned char)*cmd)) {
+                cmd++;
+            }
+            if (strcmp(cmd, "exit") == 0) {
                 break;
+            } else if (strncmp(cmd, "submit", 6) == 0 && (cmd[6] == '\0' || isspace((unsigned char)cmd[6]))) {
+                submit_job(cmd + 6, scheduler_pid, legacy_priority);
+            } else if (strncmp(cmd, "priority", 8) == 0 && (cmd[8] == '\0' || isspace((unsigned char)cmd[8]))) {
+                change_priority(cmd + 8);
+            } else if (strncmp(cmd, "slots", 5) == 0 && (cmd[5] == '\0' || isspace((unsigned char)cmd[5]))) {
+                change_slots(cmd + 5);
+            } else {
+                run_foreground(cmd);
             }
+            show_prompt = 1;
+            continue;
+        }
+
+        // Only block in poll, never in read, so signals and the scheduler are never held up
+        if (show_prompt) {
+            printf("\nSimpleShell$ ");
+            fflush(stdout);
+            show_prompt = 0;
         }
-        sem_post(&scheduler_queue_sem);
+        struct pollfd pfd = { STDIN_FILENO, POLLIN, 0 };
+        if (poll(&pfd, 1, -1) == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            perror("poll");
+            break;
+        }
+        if (line_reader_fill(&reader) == -1 && errno != EINTR) {
+            perror("read");
+            break;
+        }
+    }
+}
+
+// Function to wait for submitted jobs to finish, then stop the scheduler process
+void shutdown_scheduler(pid_t scheduler_pid) {
+    sigset_t block, old;
+    sigemptyset(&block);
+    sigaddset(&block, SIGCHLD);
+    sigprocmask(SIG_BLOCK, &block, &old);
+
+    if (scheduler_queue->rear >= 0) {
+        printf("Waiting for %d submitted process(es) to finish...\n", scheduler_queue->rear + 1);
+    }
+    if (tasks_outstanding() > 0) {
+        printf("Waiting for %d submitted task(s) to finish...\n", tasks_outstanding());
     }
+    while (scheduler_queue->rear >= 0 || tasks_outstanding() > 0) {
+        sigsuspend(&old);
+    }
+    sigprocmask(SIG_SETMASK, &old, NULL);
+
+    kill(scheduler_pid, SIGTERM);
+    waitpid(scheduler_pid, NULL, 0);
 }
@@ -1,66 +1,289 @@
 #include "../include/shell.h"
+#include "../include/daemon.h"
+#include <errno.h>
+#include <sys/socket.h>
+#include <sys/un.h>
 
 // Global variables
 HistoryEntry history[MAX_HIS];
 int history_count = 0;
 
-// Function to create a child process and run a command
-int create_process_and_run(char *cmd, int background) {
-    int status;
-    pid_t child_pid = fork();
+// Scheduler daemon that background commands are queued on, empty to start them directly
+static char scheduler_socket[108];
 
-    if (child_pid < 0) {
-        perror("Fork error");
-        exit(EXIT_FAILURE);
+// Background processes started while the history was full, which the reaper must still wait for.
+// Only changed with SIGCHLD blocked, so the handler never sees the array moved.
+static pid_t *unrecorded;
+static int unrecorded_count, unrecorded_capacity;
+
+// Function to read the monotonic clock in nanoseconds
+static long long monotonic_ns(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (long long)now.tv_sec * 1000000000LL + now.tv_nsec;
+}
+
+// Function to record a launched command in the history; returns its entry, or NULL if the history is full
+static HistoryEntry *add_history(const char *cmd, pid_t pid, int background, int queued, long long start_ns) {
+    if (history_count < MAX_HIS) {
+        HistoryEntry *entry = &history[history_count];
+        memset(entry, 0, sizeof(*entry));
+        strncpy(entry->cmd, cmd, MAX_SIZE - 1);
+        entry->pid = pid;
+        time(&entry->start_time);
+        entry->background = background;
+        entry->queued = queued;
+        entry->start_ns = start_ns;
+        history_count++; // Increment the history_count
+        return entry;
     }
-    else if (child_pid == 0) { // Child process
-        if (background) {
-            if (setsid() == -1) {
-                perror("setsid error");
-                exit(EXIT_FAILURE);
-            }
-        }
+    else {
+        fprintf(stderr, "History is full. Cannot add more entries.\n");
+        return NULL;
+    }
+}
 
-        char *args[MAX_SIZE];
-        char *token = strtok(cmd, " ");
-        int i = 0;
+// Function to store what wait4() reported for a history entry's process
+static void record_usage(HistoryEntry *entry, int status, const struct rusage *usage, long long end_ns) {
+    entry->status = status;
+    entry->wall_us = (end_ns - entry->start_ns) / 1000;
+    entry->user_us = usage->ru_utime.tv_sec * 1000000LL + usage->ru_utime.tv_usec;
+    entry->sys_us = usage->ru_stime.tv_sec * 1000000LL + usage->ru_stime.tv_usec;
+    entry->max_rss_kb = usage->ru_maxrss;
+    entry->minor_faults = usage->ru_minflt;
+    entry->major_faults = usage->ru_majflt;
+    entry->voluntary_switches = usage->ru_nvcsw;
+    entry->involuntary_switches = usage->ru_nivcsw;
+    entry->finished = 1;
+}
 
-        while (token != NULL) {
-            args[i++] = token;
-            token = strtok(NULL, " ");
+// Function to wait for a foreground process, returning its wait status and resource usage
+static void wait_foreground(pid_t pid, int *status, struct rusage *usage) {
+    while (wait4(pid, status, 0, usage) == -1) {
+        if (errno != EINTR) {
+            perror("wait4 error");
+            exit(EXIT_FAILURE);
         }
+    }
+}
 
-        args[i] = NULL;
+// Function to block or unblock SIGCHLD, so the reaper never sees a background process before its entry
+static void block_sigchld(int block) {
+    sigset_t set;
+    sigemptyset(&set);
+    sigaddset(&set, SIGCHLD);
+    sigprocmask(block ? SIG_BLOCK : SIG_UNBLOCK, &set, NULL);
+}
 
-        if (execvp(args[0], args) == -1) {
-            perror("Exec error");
-            exit(EXIT_FAILURE);
+// Function to remember a background process that got no history entry, so it is still reaped; call
+// with SIGCHLD blocked
+static void add_unrecorded(pid_t pid) {
+    if (unrecorded_count == unrecorded_capacity) {
+        int capacity = unrecorded_capacity > 0 ? unrecorded_capacity * 2 : 16;
+        pid_t *pids = realloc(unrecorded, capacity * sizeof(*pids));
+        if (pids == NULL) {
+            perror("realloc (background pids)");
+            return;
         }
+        unrecorded = pids;
+        unrecorded_capacity = capacity;
     }
-    else { // Parent process
-        if (!background) {
-            int status;
-            if (waitpid(child_pid, &status, 0) == -1) {
-                perror("Waitpid error");
-                exit(EXIT_FAILURE);
-            }
+    unrecorded[unrecorded_count++] = pid;
+}
+
+// Signal handler for SIGCHLD: reaps finished background processes and records their resource usage.
+// Foreground processes are waited for where they are started, so only background entries, and the
+// background processes the full history had no room for, are reaped.
+static void sigchld_handler(int signo) {
+    (void)signo; // Suppress unused parameter warning
+    int saved_errno = errno;
+    for (int i = 0; i < history_count; i++) {
+        HistoryEntry *entry = &history[i];
+        int status;
+        struct rusage usage;
+        if (entry->background && !entry->queued && !entry->finished &&
+            wait4(entry->pid, &status, WNOHANG, &usage) == entry->pid) {
+            record_usage(entry, status, &usage, monotonic_ns());
+        }
+    }
+    for (int i = 0; i < unrecorded_count; i++) {
+        if (waitpid(unrecorded[i], NULL, WNOHANG) == unrecorded[i]) {
+            unrecorded[i--] = unrecorded[--unrecorded_count];
         }
+    }
+    errno = saved_errno;
+}
+
+// Function to create a child process and run a command
+int create_process_and_run(char *cmd, int background) {
+    struct Command command;
+
+    int argc = parse_command(cmd, &command);
+    if (argc <= 0) {
+        return argc; // Nothing to run for an empty line
+    }
+
+    block_sigchld(background);
+    long long start_ns = monotonic_ns();
+    pid_t child_pid = spawn_command(&command, background ? SPAWN_SETSID : 0);
+    if (child_pid < 0) {
+        block_sigchld(0);
+        return -1;
+    }
 
-        // Add the command to history immediately before exiting the function
-        if (history_count < MAX_HIS) {
-            strncpy(history[history_count].cmd, cmd, MAX_SIZE);
-            history[history_count].pid = child_pid;
-            time(&history[history_count].start_time);
-            history[history_count].background = background;
-            history_count++; // Increment the history_count
+    if (!background) {
+        int status;
+        struct rusage usage;
+        wait_foreground(child_pid, &status, &usage);
+        HistoryEntry *entry = add_history(cmd, child_pid, 0, 0, start_ns);
+        if (entry != NULL) {
+            record_usage(entry, status, &usage, monotonic_ns());
         }
-        else {
-            fprintf(stderr, "History is full. Cannot add more entries.\n");
+    } else {
+        if (add_history(cmd, child_pid, 1, 0, start_ns) == NULL) {
+            add_unrecorded(child_pid);
+        }
+        block_sigchld(0);
+    }
+    return 0;
+}
+
+// Function to send one request line to the scheduler daemon and read the first line of its reply.
+// Returns 0 if the reply starts with "ok", 1 for an error reply, or -1 if the daemon is unreachable.
+static int scheduler_request(const char *path, const char *request, char *reply, size_t size) {
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, path, sizeof(addr.sun_path) - 1);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd == -1 || connect(fd, (struct sockaddr *)&addr, sizeof(addr)) == -1) {
+        perror(path);
+        if (fd != -1) {
+            close(fd);
+        }
+        return -1;
+    }
+    size_t len = strlen(request), sent = 0;
+    while (sent < len) {
+        ssize_t n = send(fd, request + sent, len - sent, MSG_NOSIGNAL);
+        if (n <= 0) {
+            perror("send");
+            close(fd);
+            return -1;
+        }
+        sent += n;
+    }
+    shutdown(fd, SHUT_WR); // The daemon closes the connection after the reply
+
+    size_t used = 0;
+    ssize_t n;
+    while (used + 1 < size && (n = recv(fd, reply + used, size - used - 1, 0)) > 0) {
+        used += n;
+    }
+    close(fd);
+    reply[used] = '\0';
+    reply[strcspn(reply, "\n")] = '\0';
+    if (strncmp(reply, "ok", 2) == 0) {
+        return 0;
+    }
+    if (strncmp(reply, "error", 5) != 0) {
+        fprintf(stderr, "%s: no reply from the scheduler\n", path);
+        return -1;
+    }
+    return 1;
+}
+
+// Function to queue background commands on the scheduler daemon at path, so they start as its slots
+// allow instead of all at once; returns 0, or -1 if no daemon answers there
+int attach_scheduler(const char *path) {
+    char reply[64];
+    if (strlen(path) >= sizeof(scheduler_socket)) {
+        fprintf(stderr, "Socket path too long: %s\n", path);
+        return -1;
+    }
+    if (scheduler_request(path, "slots\n", reply, sizeof(reply)) != 0) {
+        fprintf(stderr, "No scheduler daemon at %s; background commands still start directly\n", path);
+        return -1;
+    }
+    strcpy(scheduler_socket, path);
+    printf("Background commands are queued on the scheduler at %s (%s slots)\n", path, reply + 3);
+    return 0;
+}
+
+// Function to go back to starting background commands directly
+void detach_scheduler(void) {
+    if (scheduler_socket[0] != '\0') {
+        printf("Background commands start directly again; jobs already queued stay with the scheduler\n");
+    }
+    scheduler_socket[0] = '\0';
+}
+
+// Function to submit a background command to the attached scheduler, to run in the shell's current
+// directory. The scheduler forks it, so it inherits the daemon's environment and output, not the shell's.
+static int queue_background(char *cmd) {
+    struct Command command;
+    static struct Command dir;
+    char cwd[PATH_MAX];
+    char request[MAX_SIZE + PATH_MAX + 32];
+    char reply[MAX_SIZE];
+
+    int argc = parse_command(cmd, &command);
+    if (argc <= 0) {
+        return argc; // Syntax errors are reported before anything is sent
+    }
+    if (getcwd(cwd, sizeof(cwd)) == NULL) {
+        perror("getcwd");
+        return -1;
+    }
+    dir.argv[0] = cwd;
+    dir.argv[1] = NULL;
+    dir.argc = 1;
+    strcpy(request, "submit --dir ");
+    if (format_command(&dir, request + strlen(request), sizeof(request) - strlen(request)) == -1 ||
+        strlen(request) + strlen(cmd) + 3 > sizeof(request)) {
+        fprintf(stderr, "Command too long to queue\n");
+        return -1;
+    }
+    strcat(request, " ");
+    strcat(request, cmd);
+    strcat(request, "\n");
+
+    int result = scheduler_request(scheduler_socket, request, reply, sizeof(reply));
+    if (result != 0) {
+        if (result == 1) {
+            fprintf(stderr, "Scheduler: %s\n", reply + 6);
         }
+        return -1;
     }
+    pid_t pid = (pid_t)atoi(reply + 3);
+    printf("[queued] %d %s\n", (int)pid, cmd);
+    add_history(cmd, pid, 1, 1, monotonic_ns());
     return 0;
 }
 
+// Function to find the next '&' that puts a command in the background, skipping quoted text and the
+// '&' of 2>&1; returns NULL if there is none
+static char *find_background_operator(char *cmd) {
+    char quote = '\0';
+    for (char *c = cmd; *c != '\0'; c++) {
+        if (quote != '\0') {
+            if (*c == quote) {
+                quote = '\0';
+            } else if (*c == '\\' && quote == '"' && c[1] != '\0') {
+                c++;
+            }
+        } else if (*c == '\'' || *c == '"') {
+            quote = *c;
+        } else if (*c == '\\' && c[1] != '\0') {
+            c++;
+        } else if (*c == '&' && (c == cmd || c[-1] != '>')) {
+            return c;
+        }
+    }
+    return NULL;
+}
+
 // Function to trim leading and trailing whitespace from a string
 void trim_whitespace(char *str) {
     int len = strlen(str);
@@ -86,148 +309,48 @@ void trim_whitespace(char *str) {
     str[j] = '\0';
 }
 
-// Function to update history if piped command
-int history_piped_commands(char *cmd) {
-    char *token;
-    char *saveptr;
-
-    // Tokenize the input string using "|" as the delimiter
-    token = strtok_r(cmd, "|", &saveptr);
-
-    int foreground = 0; // Flag to track whether a command is foreground or background
-
-    while (token != NULL) {
-        // Trim leading and trailing whitespace from the token
-        trim_whitespace(token);
-
-        int pipe_fd[2];
-        pid_t pid;
-
-        if (pipe(pipe_fd) == -1) {
-            perror("Pipe error");
-            exit(EXIT_FAILURE);
-        }
-
-        pid = fork();
-
-        if (pid < 0) {
-            perror("Fork error");
-            exit(EXIT_FAILURE);
-        }
-        else if (pid == 0) { // Child process (writes to the pipe)
-            close(pipe_fd[0]); // Close the read end of the pipe
-            dup2(pipe_fd[1], STDOUT_FILENO); // Redirect stdout to the pipe
-            close(pipe_fd[1]);
-
-            // You can execute the command here if needed
-            // But for this modified version, we won't execute it
-
-            exit(EXIT_SUCCESS);
-        }
-        else { // Parent process
-            close(pipe_fd[1]); // Close the write end of the pipe
-
-            // Add the command to history
-            if (history_count < MAX_HIS) {
-                strncpy(history[history_count].cmd, token, MAX_SIZE);
-                history[history_count].pid = pid;
-                time(&history[history_count].start_time);
-                history[history_count].background = foreground;
-                history_count++;
-            }
-            else {
-                printf("History is full. Cannot add more entries.\n");
-            }
-
-            waitpid(pid, NULL, 0);
-        }
-
-        token = strtok_r(NULL, "|", &saveptr);
-        foreground = 1; // Set to 1 after the first command
-    }
-
-    return 1;
-}
-
 // Function to execute piped commands
 int execute_piped_commands(char *cmd) {
-    int pipe_fd[2];
-    pid_t pid1, pid2;
-
-    if (pipe(pipe_fd) == -1) {
-        perror("Pipe error");
-        exit(EXIT_FAILURE);
-    }
+    struct Pipeline pipeline;
+    pid_t pids[MAX_PIPELINE];
 
-    pid1 = fork();
-
-    if (pid1 < 0) {
-        perror("Fork error");
-        exit(EXIT_FAILURE);
+    if (parse_pipeline(cmd, &pipeline) <= 0) {
+        return 1;
     }
-    else if (pid1 == 0) { // Child process 1 (writes to the pipe)
-        close(pipe_fd[0]); // Close the read end of the pipe
-        if (dup2(pipe_fd[1], STDOUT_FILENO) == -1) {
-            perror("dup2 error");
-            exit(EXIT_FAILURE);
-        }
-        close(pipe_fd[1]);
 
-        // Execute the first command
-        if (system(cmd) == -1) {
-            perror("System error");
-            exit(EXIT_FAILURE);
-        }
-        exit(EXIT_SUCCESS);
+    int status[MAX_PIPELINE];
+    struct rusage usage[MAX_PIPELINE];
+    long long end_ns[MAX_PIPELINE];
+    long long start_ns = monotonic_ns();
+    int started = spawn_pipeline(&pipeline, pids, 0);
+    for (int i = 0; i < started; i++) {
+        wait_foreground(pids[i], &status[i], &usage[i]);
+        end_ns[i] = monotonic_ns();
     }
-    else { // Parent process
-        pid2 = fork();
-
-        if (pid2 < 0) {
-            perror("Fork error");
-            exit(EXIT_FAILURE);
-        }
-        else if (pid2 == 0) { // Child process 2 (reads from the pipe)
-            close(pipe_fd[1]); // Close the write end of the pipe
-            if (dup2(pipe_fd[0], STDIN_FILENO) == -1) {
-                perror("dup2 error");
-                exit(EXIT_FAILURE);
-            }
-            close(pipe_fd[0]);
 
-            // Execute the second command
-            if (system(cmd) == -1) {
-                perror("System error");
-                exit(EXIT_FAILURE);
-            }
-            exit(EXIT_SUCCESS);
-        }
-        else { // Parent process
-            close(pipe_fd[0]);
-            close(pipe_fd[1]);
-
-            if (waitpid(pid1, NULL, 0) == -1) {
-                perror("waitpid error");
-                exit(EXIT_FAILURE);
-            }
-            if (waitpid(pid2, NULL, 0) == -1) {
-                perror("waitpid error");
-                exit(EXIT_FAILURE);
-            }
+    // Add every stage of the pipeline to history, with its own resource usage
+    char *saveptr;
+    char *token = strtok_r(cmd, "|", &saveptr);
+    for (int i = 0; i < started && token != NULL; i++) {
+        trim_whitespace(token);
+        HistoryEntry *entry = add_history(token, pids[i], 0, 0, start_ns);
+        if (entry != NULL) {
+            record_usage(entry, status[i], &usage[i], end_ns[i]);
         }
+        token = strtok_r(NULL, "|", &saveptr);
     }
-    history_piped_commands(cmd);
     return 1;
 }
 
 // Signal handler for Ctrl+C
 void sigint_handler(int signo) {
+    (void)signo; // Suppress unused parameter warning
     printf("\nExiting the shell...........\n");
     display_history();
     exit(0);
 }
 
-// Setup signal handler for Ctrl+C
+// Setup signal handlers for Ctrl+C and for reaping background processes
 void setup_signal_handler(void) {
     struct sigaction sa;
     sa.sa_handler = sigint_handler;
@@ -240,6 +363,12 @@ void setup_signal_handler(void) {
         perror("sigaction error");
         exit(EXIT_FAILURE);
     }
+    sa.sa_handler = sigchld_handler;
+    sa.sa_flags = SA_RESTART | SA_NOCLDSTOP;
+    if (sigaction(SIGCHLD, &sa, NULL) == -1) {
+        perror("sigaction error");
+        exit(EXIT_FAILURE);
+    }
 }
 
 // Main shell loop
@@ -271,30 +400,46 @@ int launch(char *cmd) {
     if (strcmp(cmd, "history") == 0) {
         display_history();
     }
+    else if (strncmp(cmd, "history ", 8) == 0) {
+        display_history_stats(cmd + 8);
+    }
     else if (strcmp(cmd, "exit") == 0) {
         display_history();
         printf("\nShell ended successfully!\n");
         return 0;
     }
-    else if (strstr(cmd, "&") != NULL) {
+    else if (strncmp(cmd, "attach", 6) == 0 && (cmd[6] == '\0' || isspace((unsigned char)cmd[6]))) {
+        char path[MAX_SIZE];
+        snprintf(path, sizeof(path), "%s", cmd + 6);
+        trim_whitespace(path);
+        attach_scheduler(path[0] != '\0' ? path : DEFAULT_SOCKET_PATH);
+    }
+    else if (strcmp(cmd, "detach") == 0) {
+        detach_scheduler();
+    }
+    else if (find_background_operator(cmd) != NULL) {
         char cmd_copy[MAX_SIZE];
-        strncpy(cmd_copy, cmd, sizeof(cmd_copy)); // Create a copy of the original command
-
-        // Tokenize the input string using "&" as the delimiter
-        char *token = strtok(cmd_copy, "&"); // Split the input by "&"
-        int foreground = 0; // Flag to track whether a command is foreground or background
+        snprintf(cmd_copy, sizeof(cmd_copy), "%s", cmd); // Create a copy of the original command
 
+        // Every command followed by '&' runs in the background, queued on the scheduler if one is
+        // attached; a command after the last '&' runs in the foreground
+        char *token = cmd_copy;
         while (token != NULL) {
-            // Trim leading and trailing whitespace from the token
+            char *amp = find_background_operator(token);
+            if (amp != NULL) {
+                *amp = '\0';
+            }
             trim_whitespace(token);
-            if (create_process_and_run(token, foreground) == -1) {
-                fprintf(stderr, "Error launching command: %s\n", token);
-                return 1;
+            if (*token != '\0') {
+                int background = (amp != NULL);
+                int result = background && scheduler_socket[0] != '\0' ? queue_background(token)
+                                                                       : create_process_and_run(token, background);
+                if (result == -1) {
+                    fprintf(stderr, "Error launching command: %s\n", token);
+                    return 1;
+                }
             }
-            foreground = 1; // Set to 1 after the first command
-
-            // Get the next token
-            token = strtok(NULL, "&");
+            token = amp != NULL ? amp + 1 : NULL;
         }
     }
     else {
@@ -306,20 +451,182 @@ int launch(char *cmd) {
     return 1;
 }
 
+// Function to describe how a finished process ended
+static void describe_status(int status, char *out, size_t size) {
+    if (WIFEXITED(status)) {
+        snprintf(out, size, "exit status %d", WEXITSTATUS(status));
+    } else if (WIFSIGNALED(status)) {
+        snprintf(out, size, "killed by signal %d", WTERMSIG(status));
+    } else {
+        snprintf(out, size, "wait status %d", status);
+    }
+}
+
 // Function to display command history
 void display_history(void) {
+    block_sigchld(1); // Background entries are not updated halfway through printing
     printf("\nCommand History:\n");
     for (int i = 0; i < history_count; i++) {
-        printf("[%d] PID: %d - %s\n", i + 1, history[i].pid, history[i].cmd);
-        printf("Start Time: %s", ctime(&history[i].start_time));
-        if (history[i].background) {
-            printf("Background Process\n");
+        HistoryEntry *entry = &history[i];
+        printf("[%d] PID: %d - %s\n", i + 1, entry->pid, entry->cmd);
+        printf("Start Time: %s", ctime(&entry->start_time));
+        if (entry->queued) {
+            printf("Background Process, queued on the scheduler\n");
+        }
+        else if (!entry->finished) {
+            printf("Background Process, still running\n");
         }
         else {
-            printf("Execution Duration: %ld seconds\n", time(NULL) - history[i].start_time);
+            char ending[48];
+            describe_status(entry->status, ending, sizeof(ending));
+            printf("%sExecution Duration: %.3f seconds, %s\n", entry->background ? "Background Process. " : "",
+                   entry->wall_us / 1e6, ending);
+            printf("Resources: %.3f s user, %.3f s sys, max RSS %ld KB, %ld major / %ld minor page faults, "
+                   "%ld voluntary / %ld involuntary context switches\n",
+                   entry->user_us / 1e6, entry->sys_us / 1e6, entry->max_rss_kb, entry->major_faults,
+                   entry->minor_faults, entry->voluntary_switches, entry->involuntary_switches);
         }
         printf("\n"); // Add a newline for better formatting
     }
+    block_sigchld(0);
+}
+
+// Keys history --stats can sort programs by, largest first
+enum { SORT_WALL, SORT_CPU, SORT_RSS, SORT_FAULTS, SORT_SWITCHES, SORT_RUNS, SORT_KEYS };
+static const char *sort_names[SORT_KEYS] = { "wall", "cpu", "rss", "faults", "switches", "runs" };
+
+// Structure for the resource usage of one program summed over its finished commands
+struct CommandStats {
+    char program[64];
+    int runs;
+    long long wall_us;
+    long long max_wall_us;
+    long long cpu_us;
+    long max_rss_kb;
+    long major_faults;
+    long minor_faults;
+    long voluntary_switches;
+    long involuntary_switches;
+};
+
+static int stats_sort_key; // For compare_stats
+
+// Function to get the value of a program's aggregates that it is sorted by
+static long long stats_value(const struct CommandStats *stats) {
+    switch (stats_sort_key) {
+    case SORT_CPU:
+        return stats->cpu_us;
+    case SORT_RSS:
+        return stats->max_rss_kb;
+    case SORT_FAULTS:
+        return stats->major_faults + stats->minor_faults;
+    case SORT_SWITCHES:
+        return stats->voluntary_switches + stats->involuntary_switches;
+    case SORT_RUNS:
+        return stats->runs;
+    default:
+        return stats->wall_us;
+    }
+}
+
+// Function to order programs by the sort key, largest first
+static int compare_stats(const void *a, const void *b) {
+    long long x = stats_value(a), y = stats_value(b);
+    return x < y ? 1 : x > y ? -1 : strcmp(((const struct CommandStats *)a)->program,
+                                          ((const struct CommandStats *)b)->program);
+}
+
+// Function to display "history --stats [-n N] [--sort KEY]": the finished commands' resource usage summed
+// per program, for the top N programs by KEY
+void display_history_stats(const char *args) {
+    static struct CommandStats stats[MAX_HIS];
+    struct Command options;
+    int top = DEFAULT_STATS_TOP;
+    int valid = parse_command(args, &options) > 0 && strcmp(options.argv[0], "--stats") == 0;
+
+    stats_sort_key = SORT_WALL;
+    for (int i = 1; valid && i < options.argc; i += 2) {
+        if (i + 1 == options.argc) {
+            valid = 0;
+        } else if (strcmp(options.argv[i], "-n") == 0 || strcmp(options.argv[i], "--top") == 0) {
+            top = atoi(options.argv[i + 1]);
+            valid = top > 0;
+        } else if (strcmp(options.argv[i], "-s") == 0 || strcmp(options.argv[i], "--sort") == 0) {
+            int key = 0;
+            while (key < SORT_KEYS && strcmp(options.argv[i + 1], sort_names[key]) != 0) {
+                key++;
+            }
+            stats_sort_key = key;
+            valid = key < SORT_KEYS;
+        } else {
+            valid = 0;
+        }
+    }
+    if (!valid) {
+        printf("Usage: history [--stats [-n N] [--sort wall|cpu|rss|faults|switches|runs]]\n");
+        return;
+    }
+
+    // Sum the finished commands by program
+    int count = 0, finished = 0, pending = 0;
+    block_sigchld(1);
+    for (int i = 0; i < history_count; i++) {
+        HistoryEntry *entry = &history[i];
+        struct Command command;
+        if (!entry->finished) {
+            pending++;
+            continue;
+        }
+        if (parse_command(entry->cmd, &command) <= 0) {
+            continue;
+        }
+        const char *program = strrchr(command.argv[0], '/');
+        program = program != NULL && program[1] != '\0' ? program + 1 : command.argv[0];
+
+        int s = 0;
+        while (s < count && strcmp(stats[s].program, program) != 0) {
+            s++;
+        }
+        if (s == count) {
+            memset(&stats[count], 0, sizeof(stats[count]));
+            snprintf(stats[count].program, sizeof(stats[count].program), "%s", program);
+            count++;
+        }
+        struct CommandStats *sum = &stats[s];
+        sum->runs++;
+        sum->wall_us += entry->wall_us;
+        if (entry->wall_us > sum->max_wall_us) {
+            sum->max_wall_us = entry->wall_us;
+        }
+        sum->cpu_us += entry->user_us + entry->sys_us;
+        if (entry->max_rss_kb > sum->max_rss_kb) {
+            sum->max_rss_kb = entry->max_rss_kb;
+        }
+        sum->major_faults += entry->major_faults;
+        sum->minor_faults += entry->minor_faults;
+        sum->voluntary_switches += entry->voluntary_switches;
+        sum->involuntary_switches += entry->involuntary_switches;
+        finished++;
+    }
+    block_sigchld(0);
+
+    qsort(stats, count, sizeof(stats[0]), compare_stats);
+    printf("\nCommand statistics: %d finished command(s) of %d program(s), top %d by %s\n",
+           finished, count, top < count ? top : count, sort_names[stats_sort_key]);
+    if (pending > 0) {
+        printf("(%d still running or queued on the scheduler, not counted)\n", pending);
+    }
+    printf("%-20s %5s %11s %11s %11s %11s %15s %17s\n", "program", "runs", "wall s", "max wall s",
+           "cpu s", "max RSS KB", "faults maj/min", "switches vol/inv");
+    for (int s = 0; s < count && s < top; s++) {
+        char faults[32], switches[32];
+        snprintf(faults, sizeof(faults), "%ld/%ld", stats[s].major_faults, stats[s].minor_faults);
+        snprintf(switches, sizeof(switches), "%ld/%ld", stats[s].voluntary_switches,
+                 stats[s].involuntary_switches);
+        printf("%-20.20s %5d %11.3f %11.3f %11.3f %11ld %15s %17s\n", stats[s].program, stats[s].runs,
+               stats[s].wall_us / 1e6, stats[s].max_wall_us / 1e6, stats[s].cpu_us / 1e6, stats[s].max_rss_kb,
+               faults, switches);
+    }
 }
 
 // Run shell function (for integration)
@@ -329,9 +636,22 @@ int run_shell(void) {
     return 0;
 }
 
-// Standalone shell main function
+// Standalone shell main function: "simple_shell [-s socket]" queues background commands on the
+// scheduler daemon at socket from the start
 #ifndef INTEGRATED_BUILD
-int main(void) {
+int main(int argc, char *argv[]) {
+    int opt;
+    while ((opt = getopt(argc, argv, "s:h")) != -1) {
+        if (opt == 's') {
+            if (attach_scheduler(optarg) == -1) {
+                return 1;
+            }
+        } else {
+            printf("Usage: %s [-s socket]\n", argv[0]);
+            printf("  -s socket  queue background (&) commands on the scheduler daemon listening on socket\n");
+            return opt == 'h' ? 0 : 2;
+        }
+    }
     return run_shell();
 }
 #endif
@@ -0,0 +1,172 @@
+#include "../include/snapshot.h"
+#include <fcntl.h>
+#include <sched.h>
+#include <stddef.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// Function to create the snapshot before the scheduler forks, so the front-end and the scheduler
+// share it; a name also exports it with shm_open() for readers outside this process tree
+struct SchedulerSnapshot *create_snapshot(const char *name) {
+    struct SchedulerSnapshot *snapshot;
+
+    if (name != NULL && *name != '\0') {
+        int fd = shm_open(name, O_CREAT | O_RDWR, 0644);
+        if (fd == -1) {
+            perror(name);
+            return NULL;
+        }
+        if (ftruncate(fd, sizeof(*snapshot)) == -1) {
+            perror("ftruncate (snapshot)");
+            close(fd);
+            return NULL;
+        }
+        snapshot = mmap(NULL, sizeof(*snapshot), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+    } else {
+        snapshot = mmap(NULL, sizeof(*snapshot), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    }
+    if (snapshot == MAP_FAILED) {
+        perror("mmap (snapshot)");
+        return NULL;
+    }
+    memset(snapshot, 0, sizeof(*snapshot));
+    snapshot->size = sizeof(*snapshot);
+    __atomic_store_n(&snapshot->magic, SNAPSHOT_MAGIC, __ATOMIC_RELEASE);
+    return snapshot;
+}
+
+// Function to map an exported snapshot read-only
+const struct SchedulerSnapshot *attach_snapshot(const char *name) {
+    struct stat st;
+    int fd = shm_open(name, O_RDONLY, 0);
+    if (fd == -1) {
+        perror(name);
+        return NULL;
+    }
+    if (fstat(fd, &st) == -1 || st.st_size < (off_t)sizeof(struct SchedulerSnapshot)) {
+        fprintf(stderr, "%s: not a scheduler snapshot of this version\n", name);
+        close(fd);
+        return NULL;
+    }
+    const struct SchedulerSnapshot *snapshot = mmap(NULL, sizeof(*snapshot), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (snapshot == MAP_FAILED) {
+        perror("mmap (snapshot)");
+        return NULL;
+    }
+    return snapshot;
+}
+
+// Function to remove an exported snapshot's name; readers that attached keep their mapping
+void remove_snapshot(const char *name) {
+    if (name != NULL && *name != '\0') {
+        shm_unlink(name);
+    }
+}
+
+// Function to count the positions set in a state mask
+static int mask_population(const uint64_t mask[]) {
+    int count = 0;
+    for (int w = 0; w < QUEUE_MASK_WORDS; w++) {
+        count += __builtin_popcountll(mask[w]);
+    }
+    return count;
+}
+
+// Function to publish the queue into the snapshot. Callers hold the queue lock, so there is only ever
+// one writer; the sequence counter is odd while the copy is being rewritten.
+void publish_snapshot(struct SchedulerSnapshot *snapshot, const struct ProcessQueue *queue, int ncpu,
+                      long long terminated) {
+    if (snapshot == NULL) {
+        return;
+    }
+    uint64_t seq = snapshot->seq;
+    __atomic_store_n(&snapshot->seq, seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    snapshot->published_ms = (long long)now.tv_sec * 1000 + now.tv_nsec / 1000000;
+    snapshot->tick = queue->tick;
+    snapshot->ncpu = ncpu;
+    snapshot->running = mask_population(queue->running_mask);
+    snapshot->waiting = mask_population(queue->waiting_mask);
+    snapshot->blocked = mask_population(queue->blocked_mask);
+    snapshot->terminated = terminated;
+    snapshot->job_count = queue->rear + 1;
+    for (int i = 0; i <= queue->rear; i++) {
+        const struct Process *process = &queue->processes[i];
+        struct JobSnapshot *job = &snapshot->jobs[i];
+        job->pid = process->pid;
+        job->state = process->state;
+        job->held = process->after_count > 0;
+        job->priority = process->priority;
+        job->cpu_ms = process->total_execution_time;
+        job->waiting_ms = process->waiting_time;
+        const long long *counters = process->counters;
+        job->ipc = counters[COUNTER_CYCLES] > 0 ? (double)counters[COUNTER_INSTRUCTIONS] / counters[COUNTER_CYCLES] : -1;
+        job->mpki = counters[COUNTER_INSTRUCTIONS] > 0 ?
+                    1000.0 * counters[COUNTER_LLC_MISSES] / counters[COUNTER_INSTRUCTIONS] : -1;
+        memcpy(job->tenant, queue->tenants[process->tenant].name, MAX_TENANT_NAME);
+        size_t length = strnlen(process->command, MAX_PROGRAM_NAME - 1);
+        memcpy(job->command, process->command, length);
+        job->command[length] = '\0';
+    }
+
+    __atomic_store_n(&snapshot->seq, seq + 2, __ATOMIC_RELEASE);
+}
+
+// Function to take a consistent copy of a snapshot. The reader never blocks the writer: it copies,
+// then retries if the sequence counter shows an update overlapped the copy. Returns -1 if the
+// snapshot is not valid or no untorn copy was seen (its writer died mid-update).
+int read_snapshot(const struct SchedulerSnapshot *snapshot, struct SchedulerSnapshot *copy) {
+    if (__atomic_load_n(&snapshot->magic, __ATOMIC_ACQUIRE) != SNAPSHOT_MAGIC ||
+        snapshot->size != sizeof(*snapshot)) {
+        return -1;
+    }
+    for (int attempt = 0; attempt < SNAPSHOT_READ_ATTEMPTS; attempt++) {
+        uint64_t before = __atomic_load_n(&snapshot->seq, __ATOMIC_ACQUIRE);
+        if (before & 1) {
+            sched_yield();
+            continue;
+        }
+        memcpy(copy, snapshot, offsetof(struct SchedulerSnapshot, jobs));
+        int count = copy->job_count;
+        if (count < 0 || count > MAX_PROCESSES) {
+            count = 0; // Torn; the check below rejects this copy
+        }
+        memcpy(copy->jobs, snapshot->jobs, count * sizeof(struct JobSnapshot));
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&snapshot->seq, __ATOMIC_RELAXED) == before) {
+            return 0;
+        }
+    }
+    return -1;
+}
+
+// Function to name a job's state for status output
+const char *snapshot_state_name(const struct JobSnapshot *job) {
+    if (job->state == 1 && job->held) {
+        return "held"; // Waiting on --after dependencies
+    }
+    switch (job->state) {
+        case 0:
+            return "running";
+        case 1:
+            return "waiting";
+        case 2:
+            return "blocked";
+        default:
+            return "finished";
+    }
+}
+
+// Function to format a job's IPC and LLC miss rate for status output, "-" where unknown
+void format_job_counters(const struct JobSnapshot *job, char *out, size_t size) {
+    if (job->ipc < 0 || job->mpki < 0) {
+        snprintf(out, size, "- -");
+    } else {
+        snprintf(out, size, "%.2f %.2f", job->ipc, job->mpki);
+    }
+}
@@ -0,0 +1,488 @@
+#include "../include/scheduler.h"
+#include "../include/globals.h"
+#include "../include/task.h"
+#include <dlfcn.h>
+#include <pthread.h>
+
+#define TASK_ID_BASE 4194305    // Above every pid: Linux caps pid_max at 2^22
+#define TASK_RECORD_BATCH 32    // Finished tasks a worker accounts for under one lock
+#define TASK_RECORDS_UNREAD (MAX_PROCESSES / 2) // Most unprinted records tasks may leave in the ring
+#define TASK_STEAL_MAX 32       // Most tasks a worker takes from another in one steal
+#define MAX_TASK_LIBRARIES 64
+
+// Structure for a submitted task; its argument vector and strings follow it in the same allocation
+struct Task {
+    struct TaskContext ctx;
+    TaskEntry entry;
+    const char *program;        // Entry point name, the key for run time predictions
+    int tenant;
+    uint64_t command_hash;
+    long long submitted_ns;     // Monotonic time it was queued
+    long long cpu_ns;           // Thread CPU time used over all its calls
+    struct timeval start_time;  // Wall time of the first call, zero before it
+    char *text;                 // Command line as submitted
+};
+
+// Structure for a worker's deque: a ring the owner takes from the front and thieves from the back
+struct TaskDeque {
+    pthread_mutex_t mutex;
+    struct Task **tasks;
+    int capacity;
+    int head;
+    int count;
+};
+
+// Structure for one worker thread
+struct Worker {
+    pthread_t thread;
+    int index;
+    struct TaskDeque deque;
+    struct Process done[TASK_RECORD_BATCH]; // Finished tasks not yet in the terminated queue
+    int done_count;
+    long long oldest_done_ns;   // Monotonic time the oldest of them finished
+    long long tasks;            // Tasks finished on this worker
+    long long yields;           // ... calls that ended in TASK_YIELD
+    long long steals;           // ... and steals from other workers that found work
+};
+
+// Structure for a loaded entry point
+struct TaskLibrary {
+    char spec[MAX_PROGRAM_NAME]; // "file.so:entry" as submitted
+    char program[MAX_PROGRAM_KEY];
+    TaskEntry entry;
+};
+
+static struct Worker *workers;
+static int worker_count;
+static int next_worker;                 // Deque the next submission goes to
+static pthread_t front_thread;          // Front-end thread woken when tasks finish
+static pthread_mutex_t pool_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t pool_wakeup = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t records_drained = PTHREAD_COND_INITIALIZER; // The front-end printed records
+static int idle_workers;
+static int pool_stopping;
+static volatile int waiting_tasks;      // Tasks in the deques
+static int records_admitted;            // Task records let into the terminated queue but not yet there
+static int outstanding_tasks;           // Tasks submitted and not yet in the terminated queue
+static int next_task_id = TASK_ID_BASE;
+static long long usage_carry_ns[MAX_TENANTS]; // CPU time not yet charged as a whole ms; under the queue lock
+static struct TaskLibrary libraries[MAX_TASK_LIBRARIES];
+static int library_count;
+
+// Function to read the monotonic clock in nanoseconds
+static long long monotonic_ns(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (long long)now.tv_sec * 1000000000LL + now.tv_nsec;
+}
+
+// Function to read the CPU time of the calling thread in nanoseconds
+static long long thread_cpu_ns(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+    return (long long)now.tv_sec * 1000000000LL + now.tv_nsec;
+}
+
+// Function to resolve "file.so:entry" to its entry point, loading the library the first time it is seen.
+// A file name without a '/' is looked up in the current directory, as a program path would be.
+static struct TaskLibrary *load_task_library(const char *spec) {
+    for (int l = 0; l < library_count; l++) {
+        if (strcmp(libraries[l].spec, spec) == 0) {
+            return &libraries[l];
+        }
+    }
+    if (library_count == MAX_TASK_LIBRARIES) {
+        printf("Too many task entry points (maximum %d): %s\n", MAX_TASK_LIBRARIES, spec);
+        return NULL;
+    }
+
+    char path[PATH_MAX];
+    const char *colon = strrchr(spec, ':');
+    int length = (int)(colon - spec);
+    snprintf(path, sizeof(path), "%s%.*s", memchr(spec, '/', length) != NULL ? "" : "./", length, spec);
+    void *handle = dlopen(path, RTLD_NOW | RTLD_LOCAL);
+    if (handle == NULL) {
+        printf("Cannot load task library: %s\n", dlerror());
+        return NULL;
+    }
+    void *symbol = dlsym(handle, colon + 1);
+    if (symbol == NULL) {
+        printf("Cannot find task entry point: %s\n", dlerror());
+        dlclose(handle);
+        return NULL;
+    }
+
+    struct TaskLibrary *library = &libraries[library_count++];
+    strcpy(library->spec, spec);
+    strncpy(library->program, colon + 1, MAX_PROGRAM_KEY - 1);
+    *(void **)&library->entry = symbol; // POSIX: function pointers round-trip through void *
+    return library;
+}
+
+// Function to append a task to a deque, growing its ring as needed
+static int deque_push(struct TaskDeque *deque, struct Task *task) {
+    pthread_mutex_lock(&deque->mutex);
+    if (deque->count == deque->capacity) {
+        int capacity = deque->capacity > 0 ? deque->capacity * 2 : 64;
+        struct Task **tasks = malloc(capacity * sizeof(*tasks));
+        if (tasks == NULL) {
+            pthread_mutex_unlock(&deque->mutex);
+            return -1;
+        }
+        for (int t = 0; t < deque->count; t++) {
+            tasks[t] = deque->tasks[(deque->head + t) % deque->capacity];
+        }
+        free(deque->tasks);
+        deque->tasks = tasks;
+        deque->capacity = capacity;
+        deque->head = 0;
+    }
+    deque->tasks[(deque->head + deque->count++) % deque->capacity] = task;
+    pthread_mutex_unlock(&deque->mutex);
+    return 0;
+}
+
+// Function for the owner to take the oldest task from its deque; returns NULL if it is empty
+static struct Task *deque_pop(struct TaskDeque *deque) {
+    struct Task *task = NULL;
+    pthread_mutex_lock(&deque->mutex);
+    if (deque->count > 0) {
+        task = deque->tasks[deque->head];
+        deque->head = (deque->head + 1) % deque->capacity;
+        deque->count--;
+    }
+    pthread_mutex_unlock(&deque->mutex);
+    return task;
+}
+
+// Function for a thief to take up to half of a deque from its back; returns how many it took
+static int deque_steal(struct TaskDeque *deque, struct Task *stolen[]) {
+    pthread_mutex_lock(&deque->mutex);
+    int take = (deque->count + 1) / 2;
+    if (take > TASK_STEAL_MAX) {
+        take = TASK_STEAL_MAX;
+    }
+    for (int t = 0; t < take; t++) {
+        stolen[t] = deque->tasks[(deque->head + --deque->count) % deque->capacity];
+    }
+    pthread_mutex_unlock(&deque->mutex);
+    return take;
+}
+
+// Function to queue a task on a worker's deque and wake an idle worker to run or steal it
+static int queue_task(struct Worker *worker, struct Task *task) {
+    if (deque_push(&worker->deque, task) == -1) {
+        return -1;
+    }
+    __atomic_add_fetch(&waiting_tasks, 1, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&idle_workers, __ATOMIC_SEQ_CST) > 0) {
+        pthread_mutex_lock(&pool_mutex);
+        pthread_cond_signal(&pool_wakeup);
+        pthread_mutex_unlock(&pool_mutex);
+    }
+    return 0;
+}
+
+// Function to move a worker's finished tasks to the terminated queue under one lock, charging their CPU
+// time to their tenants as a reaped process would be, then wake the front-end to report them
+static void flush_task_records(struct Worker *worker) {
+    if (worker->done_count == 0) {
+        return;
+    }
+
+    // While a front-end prints records as they arrive, tasks fill at most TASK_RECORDS_UNREAD of the ring
+    // ahead of it, so no record is overwritten unprinted and half the ring stays free for process exits
+    pthread_mutex_lock(&pool_mutex);
+    while (__atomic_load_n(&terminated_queue->draining, __ATOMIC_SEQ_CST) &&
+           __atomic_load_n(&terminated_queue->rear, __ATOMIC_SEQ_CST) + 1 + records_admitted + worker->done_count -
+           __atomic_load_n(&terminated_queue->reported, __ATOMIC_SEQ_CST) > TASK_RECORDS_UNREAD) {
+        pthread_cond_wait(&records_drained, &pool_mutex);
+    }
+    records_admitted += worker->done_count;
+    pthread_mutex_unlock(&pool_mutex);
+
+    while (sem_wait(&scheduler_queue->lock) == -1 && errno == EINTR) {
+    }
+    for (int r = 0; r < worker->done_count; r++) {
+        struct Process *record = &worker->done[r];
+        // Tenants are charged in ms; a microsecond task carries its share over to the next one
+        usage_carry_ns[record->tenant] += record->cpu_ns;
+        scheduler_queue->tenants[record->tenant].usage += usage_carry_ns[record->tenant] / 1000000;
+        usage_carry_ns[record->tenant] %= 1000000;
+        if (WEXITSTATUS(record->exit_status) == 0) {
+            record_runtime(record);
+        }
+        trace_exit(record);
+        terminated_queue->rear++;
+        terminated_queue->processes[terminated_queue->rear % MAX_PROCESSES] = *record;
+        record_outcome(record);
+    }
+    sem_post(&scheduler_queue->lock);
+    pthread_mutex_lock(&pool_mutex);
+    records_admitted -= worker->done_count;
+    pthread_mutex_unlock(&pool_mutex);
+
+    __atomic_sub_fetch(&outstanding_tasks, worker->done_count, __ATOMIC_SEQ_CST);
+    worker->done_count = 0;
+    pthread_kill(front_thread, SIGCHLD);
+}
+
+// Function to account for a finished task the way retire_process() does for a process
+static void finish_task(struct Worker *worker, struct Task *task, int status) {
+    struct Process *record = &worker->done[worker->done_count];
+    long long now = monotonic_ns();
+
+    memset(record, 0, sizeof(*record));
+    record->pid = task->ctx.id;
+    record->state = -1;
+    record->in_process = 1;
+    record->tenant = task->tenant;
+    record->progress_slot = -1;
+    record->node = -1;
+    record->command_hash = task->command_hash;
+    record->cpu_ns = task->cpu_ns;
+    record->total_execution_time = task->cpu_ns / 1000000;
+    // Waiting is all the time it was queued or yielded rather than running
+    record->waiting_time = (now - task->submitted_ns - task->cpu_ns) / 1000000;
+    if (record->waiting_time < 0) {
+        record->waiting_time = 0;
+    }
+    record->finish_time = now / 1000000;
+    record->exit_status = W_EXITCODE(status & 0xff, 0);
+    record->start_time = task->start_time;
+    gettimeofday(&record->end_time, NULL);
+    strncpy(record->program, task->program, MAX_PROGRAM_KEY - 1);
+    strncpy(record->command, task->text, MAX_PROGRAM_NAME - 1);
+    free(task);
+
+    if (worker->done_count++ == 0) {
+        worker->oldest_done_ns = now;
+    }
+    worker->tasks++;
+    if (worker->done_count == TASK_RECORD_BATCH || now - worker->oldest_done_ns >= TSLICE * 1000000LL) {
+        flush_task_records(worker);
+    }
+}
+
+// Function to run one call of a task: to completion, or until it yields at the end of its time slice
+static void run_task(struct Worker *worker, struct Task *task) {
+    long long now = monotonic_ns();
+    if (task->start_time.tv_sec == 0) {
+        gettimeofday(&task->start_time, NULL);
+    }
+    task->ctx.slice_end_ns = now + TSLICE * 1000000LL;
+
+    long long cpu = thread_cpu_ns();
+    int status = task->entry(&task->ctx);
+    task->cpu_ns += thread_cpu_ns() - cpu;
+
+    if (status == TASK_YIELD) {
+        // Back of the line: everything already waiting on this worker runs first
+        worker->yields++;
+        if (queue_task(worker, task) == 0) {
+            return;
+        }
+        status = 1;
+    }
+    finish_task(worker, task, status);
+}
+
+// Function to find a task for an idle worker on the others' deques, keeping the rest of what it takes
+static struct Task *steal_task(struct Worker *worker) {
+    struct Task *stolen[TASK_STEAL_MAX];
+
+    for (int n = 1; n < worker_count; n++) {
+        struct Worker *victim = &workers[(worker->index + n) % worker_count];
+        int count = deque_steal(&victim->deque, stolen);
+        if (count == 0) {
+            continue;
+        }
+        worker->steals++;
+        // Taken from the victim's back, newest first: run the oldest and queue the rest in order
+        for (int t = count - 2; t >= 0; t--) {
+            if (deque_push(&worker->deque, stolen[t]) == -1) {
+                deque_push(&victim->deque, stolen[t]);
+            }
+        }
+        return stolen[count - 1];
+    }
+    return NULL;
+}
+
+// Thread function for a worker: run its own tasks, steal when out of them, sleep when there are none
+static void *run_task_worker(void *arg) {
+    struct Worker *worker = arg;
+
+    while (1) {
+        struct Task *task = deque_pop(&worker->deque);
+        if (task == NULL) {
+            task = steal_task(worker);
+        }
+        if (task != NULL) {
+            __atomic_sub_fetch(&waiting_tasks, 1, __ATOMIC_SEQ_CST);
+            run_task(worker, task);
+            continue;
+        }
+
+        // Out of work: report what finished, then sleep until a task is queued anywhere
+        flush_task_records(worker);
+        pthread_mutex_lock(&pool_mutex);
+        __atomic_add_fetch(&idle_workers, 1, __ATOMIC_SEQ_CST);
+        while (__atomic_load_n(&waiting_tasks, __ATOMIC_SEQ_CST) == 0 && !pool_stopping) {
+            pthread_cond_wait(&pool_wakeup, &pool_mutex);
+        }
+        __atomic_sub_fetch(&idle_workers, 1, __ATOMIC_SEQ_CST);
+        int stopping = pool_stopping && waiting_tasks == 0;
+        pthread_mutex_unlock(&pool_mutex);
+        if (stopping) {
+            return NULL;
+        }
+    }
+}
+
+// Function to start one worker per slot on first use. Workers are threads of the front-end, the
+// process tasks are submitted to, so a task is queued without crossing a process boundary.
+static int start_task_pool(void) {
+    int count = NCPU > 0 ? NCPU : scheduler_queue->slots;
+    workers = calloc(count > 0 ? count : 1, sizeof(*workers));
+    if (workers == NULL) {
+        perror("calloc (task workers)");
+        return -1;
+    }
+    front_thread = pthread_self();
+
+    // Workers must not take the front-end's signals, SIGCHLD in particular
+    sigset_t all, saved;
+    sigfillset(&all);
+    pthread_sigmask(SIG_SETMASK, &all, &saved);
+    for (worker_count = 0; worker_count < (count > 0 ? count : 1); worker_count++) {
+        struct Worker *worker = &workers[worker_count];
+        worker->index = worker_count;
+        pthread_mutex_init(&worker->deque.mutex, NULL);
+        int result = pthread_create(&worker->thread, NULL, run_task_worker, worker);
+        if (result != 0) {
+            fprintf(stderr, "pthread_create (task worker): %s\n", strerror(result));
+            break;
+        }
+    }
+    pthread_sigmask(SIG_SETMASK, &saved, NULL);
+    if (worker_count == 0) {
+        free(workers);
+        workers = NULL;
+        return -1;
+    }
+    return 0;
+}
+
+// Function to get a --lib job spec ready to queue: load its library and start the worker pool on first
+// use. Call from the front-end without the queue lock, as dlopen() runs library constructors and the
+// pool starts threads. Returns the library's index for submit_task(), or -1 if the task cannot run.
+int prepare_task(const struct JobSpec *spec) {
+    if (sched_config.listen[0] != '\0') {
+        printf("Tasks run in-process and cannot be sent to nodes: %s\n", spec->text);
+        return -1;
+    }
+    struct TaskLibrary *library = load_task_library(spec->lib);
+    if (library == NULL || (workers == NULL && start_task_pool() == -1)) {
+        return -1;
+    }
+    return (int)(library - libraries);
+}
+
+// Function to queue a --lib job spec made ready by prepare_task() on the worker pool; call from the
+// front-end with the queue lock held. Returns the task's id, or 0 if it could not be queued.
+pid_t submit_task(const struct JobSpec *spec) {
+    if (spec->task_library == -1) {
+        return 0;
+    }
+    const struct TaskLibrary *library = &libraries[spec->task_library];
+
+    // The task, its argument vector and the strings it points to go in one allocation
+    const struct Command *cmd = &spec->cmd;
+    size_t strings = strlen(spec->text) + 1;
+    for (int a = 0; a < cmd->argc; a++) {
+        strings += strlen(cmd->argv[a]) + 1;
+    }
+    struct Task *task = calloc(1, sizeof(*task) + (cmd->argc + 1) * sizeof(char *) + strings);
+    if (task == NULL) {
+        perror("calloc (task)");
+        return 0;
+    }
+    char **argv = (char **)(task + 1);
+    char *text = (char *)(argv + cmd->argc + 1);
+    for (int a = 0; a < cmd->argc; a++) {
+        argv[a] = strcpy(text, cmd->argv[a]);
+        text += strlen(text) + 1;
+    }
+    task->text = strcpy(text, spec->text);
+    task->ctx.argc = cmd->argc;
+    task->ctx.argv = argv;
+    task->ctx.id = next_task_id++;
+    task->ctx.waiting = &waiting_tasks;
+    task->entry = library->entry;
+    task->program = library->program;
+    task->tenant = intern_tenant(spec->tenant);
+    task->command_hash = command_hash(cmd);
+    task->submitted_ns = monotonic_ns();
+    scheduler_queue->tenants[task->tenant].processes++;
+
+    pid_t id = task->ctx.id;
+    __atomic_add_fetch(&outstanding_tasks, 1, __ATOMIC_SEQ_CST);
+    if (queue_task(&workers[next_worker], task) == -1) {
+        perror("malloc (task deque)");
+        __atomic_sub_fetch(&outstanding_tasks, 1, __ATOMIC_SEQ_CST);
+        free(task);
+        return 0;
+    }
+    next_worker = (next_worker + 1) % worker_count;
+    return id;
+}
+
+// Function to let workers waiting for room in the terminated queue recheck it; the front-end calls it
+// after printing records
+void task_records_drained(void) {
+    if (workers == NULL) {
+        return;
+    }
+    pthread_mutex_lock(&pool_mutex);
+    pthread_cond_broadcast(&records_drained);
+    pthread_mutex_unlock(&pool_mutex);
+}
+
+// Function to count tasks submitted that have not reached the terminated queue yet
+int tasks_outstanding(void) {
+    return __atomic_load_n(&outstanding_tasks, __ATOMIC_SEQ_CST);
+}
+
+// Function to stop the worker pool once every task has finished
+void stop_task_pool(void) {
+    if (workers == NULL) {
+        return;
+    }
+    pthread_mutex_lock(&pool_mutex);
+    pool_stopping = 1;
+    pthread_cond_broadcast(&pool_wakeup);
+    pthread_mutex_unlock(&pool_mutex);
+    for (int w = 0; w < worker_count; w++) {
+        pthread_join(workers[w].thread, NULL);
+        free(workers[w].deque.tasks);
+    }
+    free(workers);
+    workers = NULL;
+}
+
+// Function to print how the worker pool ran its tasks
+void print_task_summary(void) {
+    long long tasks = 0, yields = 0, steals = 0;
+
+    if (workers == NULL) {
+        return;
+    }
+    for (int w = 0; w < worker_count; w++) {
+        tasks += workers[w].tasks;
+        yields += workers[w].yields;
+        steals += workers[w].steals;
+    }
+    printf("In-process tasks: %lld finished on %d worker(s), %lld yield(s), %lld steal(s)\n",
+           tasks, worker_count, yields, steals);
+}
@@ -0,0 +1,103 @@
+#include "../include/scheduler.h"
+#include "../include/globals.h"
+#include "../include/trace.h"
+#include <fcntl.h>
+
+static int trace_fd = -1;
+static long long trace_start;
+
+// Function to start recording submissions and exits to a trace file. Opened before the scheduler
+// forks and in append mode, so the front-end and the scheduler can both write whole lines to it.
+int open_trace(const char *path) {
+    trace_fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_APPEND | O_CLOEXEC, 0644);
+    if (trace_fd == -1) {
+        perror(path);
+        return -1;
+    }
+    trace_start = monotonic_ms();
+    dprintf(trace_fd, "%s\n", TRACE_HEADER);
+    return 0;
+}
+
+// Function to append one line to the trace with a single write, so concurrent writers never interleave
+static void write_trace_line(const char *line, int length) {
+    if (length > 0 && write(trace_fd, line, length) == -1) {
+        perror("write (trace)");
+    }
+}
+
+// Function to record a queued job with the options it was submitted with
+void trace_submit(const struct JobSpec *spec, pid_t id) {
+    static struct Command options;
+    static char number[4][24];
+    static char text[MAX_LINE + 64];
+    char after[MAX_DEPENDENCIES * 12 + 2] = "-";
+
+    if (trace_fd == -1) {
+        return;
+    }
+
+    // Rebuild the submit line with every option spelled out, quoted like the original
+    options = spec->cmd;
+    char *prefix[12];
+    int n = 0;
+    snprintf(number[0], sizeof(number[0]), "%d", spec->priority);
+    prefix[n++] = "-p";
+    prefix[n++] = number[0];
+    prefix[n++] = "-g";
+    prefix[n++] = (char *)spec->tenant;
+    if (spec->deadline != 0) {
+        snprintf(number[1], sizeof(number[1]), "%lld", spec->deadline);
+        snprintf(number[2], sizeof(number[2]), "%lld", spec->budget);
+        prefix[n++] = "--deadline";
+        prefix[n++] = number[1];
+        prefix[n++] = "--budget";
+        prefix[n++] = number[2];
+    }
+    if (spec->lib[0] != '\0') {
+        prefix[n++] = "--lib";
+        prefix[n++] = (char *)spec->lib;
+    }
+    if (spec->dir[0] != '\0') {
+        prefix[n++] = "--dir";
+        prefix[n++] = (char *)spec->dir;
+    }
+    if (options.argc + n > MAX_ARGS) {
+        fprintf(stderr, "Trace: too many arguments to record job %d\n", (int)id);
+        return;
+    }
+    memmove(options.argv + n, options.argv, (options.argc + 1) * sizeof(char *));
+    memcpy(options.argv, prefix, n * sizeof(char *));
+    options.argc += n;
+
+    int used = snprintf(text, sizeof(text), "%lld\t%s\t%d\t", monotonic_ms() - trace_start, TRACE_SUBMIT, (int)id);
+    for (int d = 0, length = 0; d < spec->after_count; d++) {
+        length += snprintf(after + length, sizeof(after) - length, "%s%d", d == 0 ? "" : ",", (int)spec->after[d]);
+    }
+    used += snprintf(text + used, sizeof(text) - used, "%s\t", after);
+    if (format_command(&options, text + used, sizeof(text) - used - 1) == -1) {
+        fprintf(stderr, "Trace: command too long to record job %d\n", (int)id);
+        return;
+    }
+    used += strlen(text + used);
+    text[used++] = '\n';
+    write_trace_line(text, used);
+}
+
+// Function to record a job leaving the queue; safe to call from the SIGCHLD handler
+void trace_exit(const struct Process *process) {
+    char text[128];
+    int code = -1;
+
+    if (trace_fd == -1) {
+        return;
+    }
+    if (process->exit_status != -1 && WIFEXITED(process->exit_status)) {
+        code = WEXITSTATUS(process->exit_status);
+    } else if (process->exit_status != -1 && WIFSIGNALED(process->exit_status)) {
+        code = 128 + WTERMSIG(process->exit_status);
+    }
+    int length = snprintf(text, sizeof(text), "%lld\t%s\t%d\t%d\t%lld\n", monotonic_ms() - trace_start,
+                          TRACE_EXIT, (int)process->pid, code, process->total_execution_time);
+    write_trace_line(text, length);
+}
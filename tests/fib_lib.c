@@ -0,0 +1,36 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include "../include/task.h"
+
+// The fibonacci workload as an in-process task, for measuring task throughput:
+//   submit --lib tests/fib_lib.so:fibonacci_task <n> [rounds]
+// computes fibonacci(n) recursively rounds times (1 by default), yielding between rounds once its
+// time slice is up. fibonacci(15) takes a few microseconds.
+
+static volatile long long sink; // Keeps the result from being optimised away
+
+// Recursive Fibonacci function (inefficient for demonstration)
+static long long fibonacci(int n) {
+    if (n <= 1) return n;
+    return fibonacci(n - 1) + fibonacci(n - 2);
+}
+
+// Task entry point; the rounds done so far are kept in ctx->state across yields
+int fibonacci_task(struct TaskContext *ctx) {
+    int n = ctx->argc > 0 ? atoi(ctx->argv[0]) : 15;
+    long rounds = ctx->argc > 1 ? atol(ctx->argv[1]) : 1;
+    long done = (long)(intptr_t)ctx->state;
+
+    if (n < 0 || n > 50 || rounds < 1) {
+        return 2;
+    }
+    while (done < rounds) {
+        sink = fibonacci(n);
+        done++;
+        if (done < rounds && task_should_yield(ctx)) {
+            ctx->state = (void *)(intptr_t)done;
+            return TASK_YIELD;
+        }
+    }
+    return 0;
+}
@@ -3,13 +3,32 @@
 #include <time.h>
 #include <unistd.h>
 #include <sys/time.h>
+#include "../include/progress.h"
+
+// Progress of the recursive computation, counted in calls
+static long long calls_done = 0;
+static long long calls_total = 0;
 
 // CPU intensive task - calculating Fibonacci using recursive method
 long long fibonacci(int n) {
+    if ((++calls_done & 0xFFFFF) == 0) {
+        progress_report(calls_done, calls_total);
+    }
     if (n <= 1) return n;
     return fibonacci(n - 1) + fibonacci(n - 2);
 }
 
+// Number of calls fibonacci(n) makes: 2 * F(n + 1) - 1
+long long fibonacci_calls(int n) {
+    long long a = 0, b = 1;
+    for (int i = 0; i < n + 1; i++) {
+        long long next = a + b;
+        a = b;
+        b = next;
+    }
+    return 2 * a - 1;
+}
+
 int main() {
     int n = 50; // Fibonacci number to calculate
     
@@ -24,7 +43,11 @@ int main() {
         usleep(200000); // 0.2 seconds
     }
     
+    // The preparation is a safe point: let shorter jobs have the CPU before the long calculation
+    progress_yield();
+
     printf("PID %d: Starting Fibonacci calculation...\n", getpid());
+    calls_total = fibonacci_calls(n);
     long long result = fibonacci(n);
     
     gettimeofday(&end, NULL);
@@ -4,9 +4,17 @@
 #include <time.h>
 #include <unistd.h>
 #include <sys/time.h>
+#include "../include/progress.h"
+
+// Progress of the recursive computation, counted in calls
+static long long calls_done = 0;
+static long long calls_total = 0;
 
 // Recursive Fibonacci function (inefficient for demonstration)
 long long fibonacci(int n) {
+    if ((++calls_done & 0xFFFFF) == 0) {
+        progress_report(calls_done, calls_total);
+    }
     if (n <= 1) return n;
     return fibonacci(n - 1) + fibonacci(n - 2);
 }
@@ -52,6 +60,8 @@ int main(int argc, char *argv[]) {
     if (use_iterative) {
         result = fibonacci_iterative(n);
     } else {
+        // fibonacci(n) makes 2 * F(n + 1) - 1 calls, so the scheduler can be told how far along it is
+        calls_total = 2 * fibonacci_iterative(n + 1) - 1;
         result = fibonacci(n);
     }
     